@@ -0,0 +1,158 @@
+/// Packs a directory of web assets into a single file that the Linux plugin
+/// maps into memory and serves under `dartcef://assets/`, see
+/// `mountAssetPack` and linux/asset_pack.h for the layout.
+///
+///   dart run dart_cef:pack_assets <directory> <output>
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+const _magic = 'DCPK';
+const _version = 1;
+const _headerSize = 16;
+const _entrySize = 40;
+
+const _mimeTypes = {
+  'html': 'text/html',
+  'htm': 'text/html',
+  'js': 'text/javascript',
+  'mjs': 'text/javascript',
+  'css': 'text/css',
+  'json': 'application/json',
+  'map': 'application/json',
+  'txt': 'text/plain',
+  'xml': 'application/xml',
+  'svg': 'image/svg+xml',
+  'png': 'image/png',
+  'jpg': 'image/jpeg',
+  'jpeg': 'image/jpeg',
+  'gif': 'image/gif',
+  'webp': 'image/webp',
+  'ico': 'image/x-icon',
+  'woff': 'font/woff',
+  'woff2': 'font/woff2',
+  'ttf': 'font/ttf',
+  'otf': 'font/otf',
+  'wasm': 'application/wasm',
+  'mp4': 'video/mp4',
+  'webm': 'video/webm',
+  'mp3': 'audio/mpeg',
+  'ogg': 'audio/ogg',
+  'wav': 'audio/wav',
+};
+
+class _Asset {
+  final File file;
+  final List<int> path;
+  final List<int> mimeType;
+  final List<int> etag;
+  final int length;
+
+  _Asset(this.file, this.path, this.mimeType, this.etag, this.length);
+}
+
+void main(List<String> args) {
+  if (args.length != 2) {
+    stderr.writeln('usage: pack_assets <directory> <output>');
+    exit(64);
+  }
+  final root = Directory(args[0]);
+  if (!root.existsSync()) {
+    stderr.writeln('${args[0]} does not exist');
+    exit(66);
+  }
+
+  final assets = <_Asset>[];
+  for (final entity in root.listSync(recursive: true, followLinks: true)) {
+    if (entity is! File) {
+      continue;
+    }
+    final relative = entity.path
+        .substring(root.path.length)
+        .replaceAll(Platform.pathSeparator, '/')
+        .replaceFirst(RegExp('^/+'), '');
+    final extension = relative.contains('.')
+        ? relative.substring(relative.lastIndexOf('.') + 1).toLowerCase()
+        : '';
+    final bytes = entity.readAsBytesSync();
+    assets.add(_Asset(
+        entity,
+        utf8.encode(relative),
+        utf8.encode(_mimeTypes[extension] ?? 'application/octet-stream'),
+        utf8.encode('"${_fnv1a(bytes)}"'),
+        bytes.length));
+  }
+  // the plugin binary searches the index by the utf-8 bytes of the path
+  assets.sort((a, b) => _compareBytes(a.path, b.path));
+
+  final strings = BytesBuilder(copy: false);
+  final index = ByteData(_headerSize + assets.length * _entrySize);
+  for (var i = 0; i < _magic.length; i++) {
+    index.setUint8(i, _magic.codeUnitAt(i));
+  }
+  index.setUint32(4, _version, Endian.little);
+  index.setUint32(8, assets.length, Endian.little);
+  index.setUint32(12, 0, Endian.little);
+
+  final stringsOffset = index.lengthInBytes;
+  int addString(List<int> value) {
+    final offset = stringsOffset + strings.length;
+    strings.add(value);
+    return offset;
+  }
+
+  final entries = <List<int>>[];
+  for (final asset in assets) {
+    entries.add([
+      addString(asset.path),
+      asset.path.length,
+      addString(asset.mimeType),
+      asset.mimeType.length,
+      addString(asset.etag),
+      asset.etag.length,
+    ]);
+  }
+
+  var dataOffset = stringsOffset + strings.length;
+  for (var i = 0; i < assets.length; i++) {
+    final base = _headerSize + i * _entrySize;
+    for (var field = 0; field < 6; field++) {
+      index.setUint32(base + field * 4, entries[i][field], Endian.little);
+    }
+    index.setUint64(base + 24, dataOffset, Endian.little);
+    index.setUint64(base + 32, assets[i].length, Endian.little);
+    dataOffset += assets[i].length;
+  }
+
+  final output = File(args[1]).openSync(mode: FileMode.write);
+  try {
+    output.writeFromSync(index.buffer.asUint8List());
+    output.writeFromSync(strings.takeBytes());
+    for (final asset in assets) {
+      output.writeFromSync(asset.file.readAsBytesSync());
+    }
+  } finally {
+    output.closeSync();
+  }
+  stdout.writeln('packed ${assets.length} files into ${args[1]}');
+}
+
+int _compareBytes(List<int> a, List<int> b) {
+  final length = a.length < b.length ? a.length : b.length;
+  for (var i = 0; i < length; i++) {
+    if (a[i] != b[i]) {
+      return a[i] - b[i];
+    }
+  }
+  return a.length - b.length;
+}
+
+/// 64 bit FNV-1a of the content, used as the ETag.
+String _fnv1a(List<int> bytes) {
+  var hash = 0xcbf29ce484222325;
+  for (final byte in bytes) {
+    hash ^= byte;
+    hash *= 0x100000001b3;
+  }
+  return hash.toUnsigned(64).toRadixString(16).padLeft(16, '0');
+}
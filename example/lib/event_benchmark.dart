@@ -0,0 +1,95 @@
+// Compares the delivery latency of browser events from the CEF UI thread to
+// the Dart listener through the event channel and through a native port.
+//
+//   flutter run --release -t lib/event_benchmark.dart
+import 'dart:async';
+
+import 'package:dart_cef/webview_cef.dart';
+import 'package:flutter/material.dart';
+
+const int _warmup = 200;
+const int _events = 5000;
+
+void main() {
+  WidgetsFlutterBinding.ensureInitialized();
+  runApp(const EventBenchmarkApp());
+}
+
+class EventBenchmarkApp extends StatefulWidget {
+  const EventBenchmarkApp({Key? key}) : super(key: key);
+
+  @override
+  State<EventBenchmarkApp> createState() => _EventBenchmarkAppState();
+}
+
+class _EventBenchmarkAppState extends State<EventBenchmarkApp> {
+  final _channelController = WebviewController();
+  final _portController = WebviewController();
+  String _report = 'loading...';
+
+  @override
+  void initState() {
+    super.initState();
+    _run();
+  }
+
+  Future<void> _run() async {
+    await _channelController.initialize(startUrl: 'about:blank');
+    await _portController.initialize(
+        startUrl: 'about:blank', nativeEvents: true);
+    await _channelController.ready;
+    await _portController.ready;
+
+    final report = [
+      _stats('event channel', await _measure(_channelController)),
+      NativeEventPort.isAvailable
+          ? _stats('native port', await _measure(_portController))
+          : 'native port not available',
+    ].join('\n');
+    debugPrint(report);
+    setState(() => _report = report);
+  }
+
+  Future<List<int>> _measure(WebviewController controller) async {
+    final latencies = <int>[];
+    var received = 0;
+    final done = Completer<void>();
+    final subscription = controller.eventProbeLatency.listen((latency) {
+      if (received++ >= _warmup) {
+        latencies.add(latency.inMicroseconds);
+      }
+      if (received == _warmup + _events) {
+        done.complete();
+      }
+    });
+    await controller.sendEventProbes(_warmup + _events);
+    await done.future;
+    await subscription.cancel();
+    return latencies;
+  }
+
+  String _stats(String name, List<int> micros) {
+    final sorted = [...micros]..sort();
+    final mean = sorted.reduce((a, b) => a + b) / sorted.length;
+    int percentile(double p) => sorted[((sorted.length - 1) * p).round()];
+    return '$name: mean ${mean.toStringAsFixed(1)}us '
+        'p50 ${percentile(0.5)}us p99 ${percentile(0.99)}us '
+        'max ${sorted.last}us';
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return MaterialApp(
+      home: Scaffold(
+        body: Column(children: [
+          Padding(padding: const EdgeInsets.all(8), child: Text(_report)),
+          Expanded(
+              child: Row(children: [
+            Expanded(child: Webview(_channelController)),
+            Expanded(child: Webview(_portController)),
+          ])),
+        ]),
+      ),
+    );
+  }
+}
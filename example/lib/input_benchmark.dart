@@ -0,0 +1,134 @@
+// Compares the per-event cost of sending mouse moves through the method
+// channel, the dart:ffi entry points and the shared memory input ring.
+//
+//   flutter run --release -t lib/input_benchmark.dart
+import 'dart:async';
+
+import 'package:dart_cef/webview_cef.dart';
+import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
+
+const int _warmup = 200;
+const int _events = 5000;
+
+void main() {
+  WidgetsFlutterBinding.ensureInitialized();
+  runApp(const InputBenchmarkApp());
+}
+
+class InputBenchmarkApp extends StatefulWidget {
+  const InputBenchmarkApp({Key? key}) : super(key: key);
+
+  @override
+  State<InputBenchmarkApp> createState() => _InputBenchmarkAppState();
+}
+
+class _InputBenchmarkAppState extends State<InputBenchmarkApp> {
+  final _controller = WebviewController();
+  String _report = 'loading...';
+
+  @override
+  void initState() {
+    super.initState();
+    _run();
+  }
+
+  Future<void> _run() async {
+    await _controller.initialize(startUrl: 'about:blank');
+    await _controller.ready;
+    final channel = MethodChannel('webview_cef/${_controller.textureId}');
+
+    final channelTimes = <int>[];
+    for (var i = 0; i < _warmup + _events; i++) {
+      final stopwatch = Stopwatch()..start();
+      await channel.invokeMethod(
+          'setCursorPos', <String, int>{'x': i % 500, 'y': i % 300});
+      if (i >= _warmup) {
+        channelTimes.add(stopwatch.elapsedMicroseconds);
+      }
+    }
+
+    final ffi = InputFfi.instance;
+    if (ffi == null) {
+      _show('${_stats('method channel round trip', channelTimes)}\n'
+          'ffi entry points not available');
+      return;
+    }
+    final callTimes = <int>[];
+    for (var i = 0; i < _warmup + _events; i++) {
+      if (i == _warmup) {
+        await _drain(ffi, _warmup);
+        ffi.latency(reset: true);
+      }
+      final stopwatch = Stopwatch()..start();
+      ffi.move(_controller.textureId, i % 500, i % 300, 0);
+      if (i >= _warmup) {
+        callTimes.add(stopwatch.elapsedMicroseconds);
+      }
+    }
+    await _drain(ffi, _events);
+    final callLatency = ffi.latency(reset: true);
+
+    // clicks are never merged, every record is delivered and measured
+    final ring = ffi.ring(_controller.textureId);
+    final ringTimes = <int>[];
+    for (var i = 0; i < _events; i++) {
+      final stopwatch = Stopwatch()..start();
+      while (!ring.push(InputType.click, i % 500, i % 300,
+          a: MouseButton.middle, b: 1, flags: i & 1)) {
+        await Future<void>.delayed(Duration.zero);
+      }
+      ringTimes.add(stopwatch.elapsedMicroseconds);
+    }
+    while (ring.pending > 0) {
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+    final ringLatency = ffi.latency();
+    _show([
+      _stats('method channel round trip', channelTimes),
+      _stats('ffi call', callTimes),
+      _latency('ffi call to delivery', callLatency),
+      _stats('ring push', ringTimes),
+      _latency('ring push to delivery', ringLatency),
+    ].join('\n'));
+  }
+
+  String _latency(String name, InputLatency latency) {
+    return '$name: mean '
+        '${(latency.totalNs / latency.events / 1000).toStringAsFixed(1)}us '
+        'max ${(latency.maxNs / 1000).toStringAsFixed(1)}us '
+        '(${latency.events} events)';
+  }
+
+  /// Waits until the CEF UI thread delivered [count] events.
+  Future<void> _drain(InputFfi ffi, int count) async {
+    while (ffi.latency().events < count) {
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+  }
+
+  String _stats(String name, List<int> micros) {
+    final sorted = [...micros]..sort();
+    final mean = sorted.reduce((a, b) => a + b) / sorted.length;
+    int percentile(double p) => sorted[((sorted.length - 1) * p).round()];
+    return '$name: mean ${mean.toStringAsFixed(1)}us '
+        'p50 ${percentile(0.5)}us p99 ${percentile(0.99)}us';
+  }
+
+  void _show(String report) {
+    debugPrint(report);
+    setState(() => _report = report);
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return MaterialApp(
+      home: Scaffold(
+        body: Column(children: [
+          Padding(padding: const EdgeInsets.all(8), child: Text(_report)),
+          Expanded(child: Webview(_controller)),
+        ]),
+      ),
+    );
+  }
+}
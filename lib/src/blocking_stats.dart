@@ -0,0 +1,20 @@
+/// Counters of the request blocking policy of a single browser.
+class BlockingStats {
+  final int blockedRequests;
+
+  /// Based on the average size of responses of the same resource type.
+  final int estimatedBytesSaved;
+  final int rules;
+
+  const BlockingStats(
+      {required this.blockedRequests,
+      required this.estimatedBytesSaved,
+      required this.rules});
+
+  factory BlockingStats.fromMap(Map<dynamic, dynamic> map) {
+    return BlockingStats(
+        blockedRequests: map['blockedRequests'] ?? 0,
+        estimatedBytesSaved: map['estimatedBytesSaved'] ?? 0,
+        rules: map['rules'] ?? 0);
+  }
+}
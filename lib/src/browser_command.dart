@@ -0,0 +1,30 @@
+import 'dart:typed_data';
+import 'dart:ui';
+
+/// One step of [WebviewController.applyBatch].
+class BrowserCommand {
+  final String name;
+  final Object value;
+
+  const BrowserCommand._(this.name, this.value);
+
+  /// Resizes the browser surface.
+  factory BrowserCommand.size(Size size) => BrowserCommand._('setSize',
+      Int32List.fromList([size.width.round(), size.height.round()]));
+
+  /// Moves the browser to [offset] in the window.
+  factory BrowserCommand.offset(Offset offset) => BrowserCommand._('setOffset',
+      Int32List.fromList([offset.dx.round(), offset.dy.round()]));
+
+  /// Makes the browser the receiver of key events.
+  factory BrowserCommand.current(bool current) =>
+      BrowserCommand._('setCurrent', current);
+
+  factory BrowserCommand.hidden(bool hidden) =>
+      BrowserCommand._('setHidden', hidden);
+
+  factory BrowserCommand.zoomLevel(double level) =>
+      BrowserCommand._('setZoomLevel', level);
+
+  List<Object> toList() => [name, value];
+}
@@ -0,0 +1,22 @@
+/// How much of a page load was served from the http cache.
+class CacheStats {
+  final int requests;
+  final int cachedRequests;
+
+  /// Encoded bytes that came over the network.
+  final int networkBytes;
+
+  const CacheStats(
+      {required this.requests,
+      required this.cachedRequests,
+      required this.networkBytes});
+
+  double get hitRatio => requests == 0 ? 0 : cachedRequests / requests;
+
+  factory CacheStats.fromMap(Map<dynamic, dynamic> map) {
+    return CacheStats(
+        requests: map['requests'] ?? 0,
+        cachedRequests: map['cachedRequests'] ?? 0,
+        networkBytes: map['networkBytes'] ?? 0);
+  }
+}
@@ -12,4 +12,9 @@ enum WebviewEvent {
   cookiesCleared,
   tokenUpdated,
   accessTokenUpdated
-}
\ No newline at end of file
+}
+/// Minimum level of the plugin's own log messages.
+enum LogLevel { debug, info, warning, error, none }
+
+/// What a [LoadPolicy] does with a category of resources.
+enum ResourceAction { allow, defer, cancel }
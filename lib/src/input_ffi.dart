@@ -0,0 +1,226 @@
+import 'dart:ffi';
+import 'dart:io';
+
+/// CEF mouse buttons.
+class MouseButton {
+  static const int left = 0;
+  static const int middle = 1;
+  static const int right = 2;
+}
+
+/// CEF event flags for [InputFfi] modifiers.
+class InputModifiers {
+  static const int shift = 1 << 1;
+  static const int control = 1 << 2;
+  static const int alt = 1 << 3;
+  static const int leftButton = 1 << 4;
+  static const int middleButton = 1 << 5;
+  static const int rightButton = 1 << 6;
+}
+
+/// Record types of an [InputRing].
+class InputType {
+  static const int move = 0;
+  static const int click = 1;
+  static const int wheel = 2;
+}
+
+/// Mirrors DartCefInputRecord.
+class InputRecord extends Struct {
+  @Uint32()
+  external int type;
+
+  @Uint32()
+  external int modifiers;
+
+  @Int32()
+  external int x;
+
+  @Int32()
+  external int y;
+
+  @Int32()
+  external int a;
+
+  @Int32()
+  external int b;
+
+  @Uint32()
+  external int flags;
+
+  @Uint32()
+  external int reserved;
+
+  @Int64()
+  external int timestampUs;
+}
+
+/// Mirrors DartCefInputRing, head and tail sit on their own cache lines.
+class InputRingHeader extends Struct {
+  @Uint32()
+  external int capacity;
+
+  @Uint32()
+  external int reserved;
+
+  external Pointer<InputRecord> records;
+
+  @Array(48)
+  external Array<Uint8> padding0;
+
+  @Uint64()
+  external int head;
+
+  @Array(56)
+  external Array<Uint8> padding1;
+
+  @Uint64()
+  external int tail;
+
+  @Array(56)
+  external Array<Uint8> padding2;
+}
+
+class InputLatency extends Struct {
+  @Int64()
+  external int events;
+
+  @Int64()
+  external int totalNs;
+
+  @Int64()
+  external int maxNs;
+}
+
+typedef _VersionNative = Int32 Function();
+typedef _Version = int Function();
+typedef _MoveNative = Void Function(Int64, Int32, Int32, Uint32);
+typedef _Move = void Function(int, int, int, int);
+typedef _ClickNative = Void Function(
+    Int64, Int32, Int32, Int32, Int32, Int32, Uint32);
+typedef _Click = void Function(int, int, int, int, int, int, int);
+typedef _WheelNative = Void Function(Int64, Int32, Int32, Int32, Int32, Uint32);
+typedef _Wheel = void Function(int, int, int, int, int, int);
+typedef _LatencyNative = InputLatency Function(Int32);
+typedef _Latency = InputLatency Function(int);
+typedef _RingCreateNative = Pointer<InputRingHeader> Function(Int64, Uint32);
+typedef _RingCreate = Pointer<InputRingHeader> Function(int, int);
+typedef _RingCommitNative = Void Function(Pointer<InputRingHeader>, Uint64);
+typedef _RingCommit = void Function(Pointer<InputRingHeader>, int);
+typedef _RingDestroyNative = Void Function(Pointer<InputRingHeader>);
+typedef _RingDestroy = void Function(Pointer<InputRingHeader>);
+
+/// Input queue in native memory shared with the CEF UI thread. Events are
+/// written in place and published with one store, the UI thread is only
+/// woken when it is not already draining, and consecutive moves are merged.
+class InputRing {
+  final Pointer<InputRingHeader> _header;
+  final InputFfi _ffi;
+  int _head;
+  bool _destroyed = false;
+
+  InputRing._(this._header, this._ffi) : _head = _header.ref.head;
+
+  /// Events written but not yet delivered.
+  int get pending => _head - _header.ref.tail;
+
+  /// Queues an event, false if the ring is full or destroyed.
+  bool push(int type, int x, int y,
+      {int a = 0, int b = 0, int flags = 0, int modifiers = 0}) {
+    if (_destroyed) {
+      return false;
+    }
+    final header = _header.ref;
+    if (_head - header.tail >= header.capacity) {
+      return false;
+    }
+    final record = header.records[_head & (header.capacity - 1)];
+    record.type = type;
+    record.modifiers = modifiers;
+    record.x = x;
+    record.y = y;
+    record.a = a;
+    record.b = b;
+    record.flags = flags;
+    record.timestampUs = DateTime.now().microsecondsSinceEpoch;
+    _head++;
+    _ffi._ringCommit(_header, _head);
+    return true;
+  }
+
+  bool move(int x, int y, int modifiers) =>
+      push(InputType.move, x, y, modifiers: modifiers);
+
+  bool click(int x, int y, int button, bool up, int clickCount,
+          int modifiers) =>
+      push(InputType.click, x, y,
+          a: button, b: clickCount, flags: up ? 1 : 0, modifiers: modifiers);
+
+  bool wheel(int x, int y, int deltaX, int deltaY, int modifiers) =>
+      push(InputType.wheel, x, y,
+          a: deltaX, b: deltaY, modifiers: modifiers);
+
+  /// Frees the ring, events not drained yet are dropped.
+  void destroy() {
+    if (!_destroyed) {
+      _destroyed = true;
+      _ffi._ringDestroy(_header);
+    }
+  }
+}
+
+/// Sends input straight to the plugin's exported C functions, skipping the
+/// method channel codec and the platform thread.
+class InputFfi {
+  static const int _version = 2;
+
+  /// Null where the entry points are missing, e.g. on other platforms.
+  static final InputFfi? instance = _load();
+
+  final _Move move;
+  final _Click click;
+  final _Wheel wheel;
+  final _Latency _latency;
+  final _RingCreate _ringCreate;
+  final _RingCommit _ringCommit;
+  final _RingDestroy _ringDestroy;
+
+  InputFfi._(this.move, this.click, this.wheel, this._latency,
+      this._ringCreate, this._ringCommit, this._ringDestroy);
+
+  /// Returns the input ring of the browser with [textureId].
+  InputRing ring(int textureId, {int capacity = 1024}) =>
+      InputRing._(_ringCreate(textureId, capacity), this);
+
+  /// Delivery delay of the events sent so far, [reset] starts over.
+  InputLatency latency({bool reset = false}) => _latency(reset ? 1 : 0);
+
+  static InputFfi? _load() {
+    if (!Platform.isLinux) {
+      return null;
+    }
+    try {
+      // the plugin library is loaded with the runner
+      final library = DynamicLibrary.process();
+      final version = library
+          .lookupFunction<_VersionNative, _Version>('dart_cef_input_version');
+      if (version() != _version) {
+        return null;
+      }
+      return InputFfi._(
+          library.lookupFunction<_MoveNative, _Move>('dart_cef_input_move'),
+          library.lookupFunction<_ClickNative, _Click>('dart_cef_input_click'),
+          library.lookupFunction<_WheelNative, _Wheel>('dart_cef_input_wheel'),
+          library.lookupFunction<_LatencyNative, _Latency>(
+              'dart_cef_input_latency'),
+          library.lookupFunction<_RingCreateNative, _RingCreate>(
+              'dart_cef_input_ring_create'),
+          library.lookupFunction<_RingCommitNative, _RingCommit>(
+              'dart_cef_input_ring_commit'),
+          library.lookupFunction<_RingDestroyNative, _RingDestroy>(
+              'dart_cef_input_ring_destroy'));
+    } on ArgumentError {
+      return null;
+    }
+  }
+}
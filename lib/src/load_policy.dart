@@ -0,0 +1,45 @@
+import 'enums.dart';
+
+/// Per-browser policy that holds back or drops whole resource categories to
+/// save cpu, see [WebviewController.setLoadPolicy].
+class LoadPolicy {
+  final ResourceAction images;
+  final ResourceAction fonts;
+  final ResourceAction media;
+  final ResourceAction thirdPartyScripts;
+
+  /// Images with a larger response are aborted, 0 disables the limit.
+  final int maxImageBytes;
+
+  /// How long deferred requests are held back.
+  final Duration deferDelay;
+
+  const LoadPolicy(
+      {this.images = ResourceAction.allow,
+      this.fonts = ResourceAction.allow,
+      this.media = ResourceAction.allow,
+      this.thirdPartyScripts = ResourceAction.allow,
+      this.maxImageBytes = 0,
+      this.deferDelay = const Duration(seconds: 2)});
+
+  /// Loads everything.
+  static const full = LoadPolicy();
+
+  /// For dashboards on weak hardware: no web fonts, media or third party
+  /// scripts, images are loaded late and only up to 512 KiB.
+  static const lite = LoadPolicy(
+      images: ResourceAction.defer,
+      fonts: ResourceAction.cancel,
+      media: ResourceAction.cancel,
+      thirdPartyScripts: ResourceAction.cancel,
+      maxImageBytes: 512 * 1024);
+
+  Map<String, dynamic> toMap() => {
+        'images': images.index,
+        'fonts': fonts.index,
+        'media': media.index,
+        'thirdPartyScripts': thirdPartyScripts.index,
+        'maxImageBytes': maxImageBytes,
+        'deferMs': deferDelay.inMilliseconds,
+      };
+}
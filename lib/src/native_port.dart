@@ -0,0 +1,44 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+typedef _InitNative = Void Function(Pointer<Void>);
+typedef _Init = void Function(Pointer<Void>);
+
+/// Event transport from the plugin to a [ReceivePort] through
+/// `Dart_PostCObject`, skipping the event channel codec and the platform
+/// thread.
+class NativeEventPort {
+  /// False where the entry point is missing, e.g. on other platforms.
+  static final bool isAvailable = _init();
+
+  static bool _init() {
+    if (!Platform.isLinux) {
+      return false;
+    }
+    try {
+      final init = DynamicLibrary.process()
+          .lookupFunction<_InitNative, _Init>('dart_cef_native_port_init');
+      init(NativeApi.postCObject.cast());
+      return true;
+    } on ArgumentError {
+      return false;
+    }
+  }
+
+  /// Rebuilds the maps of a posted message, they arrive as lists starting
+  /// with null followed by the keys and values.
+  static Object? decode(Object? value) {
+    if (value is! List || value is TypedData) {
+      return value;
+    }
+    if (value.isNotEmpty && value.first == null) {
+      final map = <dynamic, dynamic>{};
+      for (var i = 1; i + 1 < value.length; i += 2) {
+        map[value[i]] = decode(value[i + 1]);
+      }
+      return map;
+    }
+    return value.map(decode).toList();
+  }
+}
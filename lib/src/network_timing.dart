@@ -0,0 +1,95 @@
+import 'dart:typed_data';
+
+/// Timing of a single request, times are relative to the first request of
+/// the page load.
+class RequestTiming {
+  final String url;
+
+  /// The CEF resource type, e.g. 0 for the main frame and 8 for images.
+  final int resourceType;
+  final Duration start;
+
+  /// When the response headers arrived, null if there was no response.
+  final Duration? responseStart;
+  final Duration end;
+  final int receivedBytes;
+
+  /// The http status code, 0 without a response.
+  final int status;
+
+  /// The CEF url request status, 1 for success.
+  final int result;
+
+  const RequestTiming(
+      {required this.url,
+      required this.resourceType,
+      required this.start,
+      required this.responseStart,
+      required this.end,
+      required this.receivedBytes,
+      required this.status,
+      required this.result});
+
+  /// Time until the first response byte, the backend latency.
+  Duration? get waiting =>
+      responseStart == null ? null : responseStart! - start;
+
+  Duration get duration => end - start;
+
+  bool get succeeded => result == 1;
+}
+
+/// The requests of a page load, reported when loading stops. Requests that
+/// complete after that are reported with the next navigation, in another
+/// [NetworkTiming] with the same [page].
+class NetworkTiming {
+  /// Identifies the page load within the browser.
+  final int page;
+
+  /// Sorted by completion.
+  final List<RequestTiming> requests;
+
+  /// Requests left out because the page made too many.
+  final int dropped;
+
+  const NetworkTiming(
+      {this.page = 0, required this.requests, required this.dropped});
+
+  int get receivedBytes =>
+      requests.fold(0, (total, request) => total + request.receivedBytes);
+
+  /// The [count] requests with the longest [RequestTiming.waiting].
+  List<RequestTiming> slowest([int count = 10]) {
+    final answered =
+        requests.where((request) => request.responseStart != null).toList()
+          ..sort((a, b) => b.waiting!.compareTo(a.waiting!));
+    return answered.take(count).toList();
+  }
+
+  factory NetworkTiming.fromMap(Map<dynamic, dynamic> map) {
+    final urls = List<String>.from(map['url']);
+    final type = map['type'] as Uint8List;
+    final start = map['start'] as Int64List;
+    final responseStart = map['responseStart'] as Int64List;
+    final end = map['end'] as Int64List;
+    final bytes = map['bytes'] as Int64List;
+    final status = map['status'] as Int32List;
+    final result = map['result'] as Uint8List;
+    return NetworkTiming(
+        page: map['page'] ?? 0,
+        requests: List<RequestTiming>.generate(
+            urls.length,
+            (i) => RequestTiming(
+                url: urls[i],
+                resourceType: type[i],
+                start: Duration(microseconds: start[i]),
+                responseStart: responseStart[i] < 0
+                    ? null
+                    : Duration(microseconds: responseStart[i]),
+                end: Duration(microseconds: end[i]),
+                receivedBytes: bytes[i],
+                status: status[i],
+                result: result[i])),
+        dropped: map['dropped'] ?? 0);
+  }
+}
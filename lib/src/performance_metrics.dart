@@ -0,0 +1,66 @@
+/// Cumulative counters of the DevTools Performance domain of one browser.
+class PerformanceMetrics {
+  final int layoutCount;
+  final int recalcStyleCount;
+  final double layoutDurationMs;
+  final double recalcStyleDurationMs;
+  final double scriptDurationMs;
+  final double taskDurationMs;
+  final int jsHeapUsed;
+  final int jsHeapTotal;
+  final int nodes;
+
+  const PerformanceMetrics(
+      {required this.layoutCount,
+      required this.recalcStyleCount,
+      required this.layoutDurationMs,
+      required this.recalcStyleDurationMs,
+      required this.scriptDurationMs,
+      required this.taskDurationMs,
+      required this.jsHeapUsed,
+      required this.jsHeapTotal,
+      required this.nodes});
+
+  /// Decodes the compact list sent with the `performanceMetrics` event.
+  factory PerformanceMetrics.fromList(List<double> values) {
+    return PerformanceMetrics(
+        layoutCount: values[0].toInt(),
+        recalcStyleCount: values[1].toInt(),
+        layoutDurationMs: values[2],
+        recalcStyleDurationMs: values[3],
+        scriptDurationMs: values[4],
+        taskDurationMs: values[5],
+        jsHeapUsed: values[6].toInt(),
+        jsHeapTotal: values[7].toInt(),
+        nodes: values[8].toInt());
+  }
+
+  factory PerformanceMetrics.fromMap(Map<dynamic, dynamic> map) {
+    return PerformanceMetrics(
+        layoutCount: map['layoutCount'] ?? 0,
+        recalcStyleCount: map['recalcStyleCount'] ?? 0,
+        layoutDurationMs: (map['layoutDurationMs'] ?? 0).toDouble(),
+        recalcStyleDurationMs: (map['recalcStyleDurationMs'] ?? 0).toDouble(),
+        scriptDurationMs: (map['scriptDurationMs'] ?? 0).toDouble(),
+        taskDurationMs: (map['taskDurationMs'] ?? 0).toDouble(),
+        jsHeapUsed: map['jsHeapUsed'] ?? 0,
+        jsHeapTotal: map['jsHeapTotal'] ?? 0,
+        nodes: map['nodes'] ?? 0);
+  }
+
+  /// Counters accumulated since [previous], e.g. layouts per interval.
+  /// Heap and node counts are kept as they are.
+  PerformanceMetrics since(PerformanceMetrics previous) {
+    return PerformanceMetrics(
+        layoutCount: layoutCount - previous.layoutCount,
+        recalcStyleCount: recalcStyleCount - previous.recalcStyleCount,
+        layoutDurationMs: layoutDurationMs - previous.layoutDurationMs,
+        recalcStyleDurationMs:
+            recalcStyleDurationMs - previous.recalcStyleDurationMs,
+        scriptDurationMs: scriptDurationMs - previous.scriptDurationMs,
+        taskDurationMs: taskDurationMs - previous.taskDurationMs,
+        jsHeapUsed: jsHeapUsed,
+        jsHeapTotal: jsHeapTotal,
+        nodes: nodes);
+  }
+}
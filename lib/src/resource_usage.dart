@@ -0,0 +1,78 @@
+import 'performance_metrics.dart';
+
+/// Resource usage of a single browser as sampled by the native side.
+class ResourceUsage {
+  final int rendererPid;
+  final double cpuTimeMs;
+  final double cpuPercent;
+  final int rssBytes;
+  final int jsHeapUsed;
+  final int jsHeapTotal;
+  final int paintCount;
+  final int paintBytes;
+
+  /// Frames dropped because they were painted for a previous size.
+  final int discardedFrames;
+
+  /// Dirty pixels of all frames painted so far.
+  final int rasterPixels;
+
+  /// Dirty pixels painted per second during the last sampling interval, see
+  /// [setResourceSamplingInterval].
+  final double rasterPixelsPerSecond;
+
+  /// Device pixels per logical pixel the page is painted at.
+  final double paintScale;
+
+  /// Times the frame buffers were released while hidden.
+  final int bufferReleases;
+
+  /// Bytes freed by those releases in total.
+  final int releasedBufferBytes;
+
+  /// Size of the hidden snapshot currently kept.
+  final int snapshotBytes;
+
+  /// Only set while performance metrics are collected for the browser.
+  final PerformanceMetrics? performance;
+
+  const ResourceUsage(
+      {required this.rendererPid,
+      required this.cpuTimeMs,
+      required this.cpuPercent,
+      required this.rssBytes,
+      required this.jsHeapUsed,
+      required this.jsHeapTotal,
+      required this.paintCount,
+      required this.paintBytes,
+      this.discardedFrames = 0,
+      this.rasterPixels = 0,
+      this.rasterPixelsPerSecond = 0,
+      this.paintScale = 1,
+      this.bufferReleases = 0,
+      this.releasedBufferBytes = 0,
+      this.snapshotBytes = 0,
+      this.performance});
+
+  factory ResourceUsage.fromMap(Map<dynamic, dynamic> map) {
+    return ResourceUsage(
+        rendererPid: map['rendererPid'] ?? 0,
+        cpuTimeMs: (map['cpuTimeMs'] ?? 0).toDouble(),
+        cpuPercent: (map['cpuPercent'] ?? 0).toDouble(),
+        rssBytes: map['rssBytes'] ?? 0,
+        jsHeapUsed: map['jsHeapUsed'] ?? 0,
+        jsHeapTotal: map['jsHeapTotal'] ?? 0,
+        paintCount: map['paintCount'] ?? 0,
+        paintBytes: map['paintBytes'] ?? 0,
+        discardedFrames: map['discardedFrames'] ?? 0,
+        rasterPixels: map['rasterPixels'] ?? 0,
+        rasterPixelsPerSecond: (map['rasterPixelsPerSecond'] ?? 0).toDouble(),
+        paintScale: (map['paintScale'] ?? 1).toDouble(),
+        bufferReleases: map['bufferReleases'] ?? 0,
+        releasedBufferBytes: map['releasedBufferBytes'] ?? 0,
+        snapshotBytes: map['snapshotBytes'] ?? 0,
+        performance: map['performance'] == null
+            ? null
+            : PerformanceMetrics.fromMap(map['performance']));
+  }
+}
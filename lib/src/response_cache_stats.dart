@@ -0,0 +1,38 @@
+/// Counters of the response cache shared by all browsers, see
+/// [setResponseCache].
+class ResponseCacheStats {
+  final int hits;
+
+  /// Requests that started a fetch.
+  final int misses;
+
+  /// Requests answered by a fetch another request started.
+  final int coalesced;
+  final int evictions;
+  final int entries;
+  final int bytes;
+
+  const ResponseCacheStats(
+      {required this.hits,
+      required this.misses,
+      required this.coalesced,
+      required this.evictions,
+      required this.entries,
+      required this.bytes});
+
+  /// Share of requests that did not reach the backend.
+  double get savedRatio {
+    final total = hits + misses + coalesced;
+    return total == 0 ? 0 : (hits + coalesced) / total;
+  }
+
+  factory ResponseCacheStats.fromMap(Map<dynamic, dynamic> map) {
+    return ResponseCacheStats(
+        hits: map['hits'] ?? 0,
+        misses: map['misses'] ?? 0,
+        coalesced: map['coalesced'] ?? 0,
+        evictions: map['evictions'] ?? 0,
+        entries: map['entries'] ?? 0,
+        bytes: map['bytes'] ?? 0);
+  }
+}
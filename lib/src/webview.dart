@@ -1,16 +1,28 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:isolate';
 
 import 'package:flutter/gestures.dart';
 import 'package:flutter/material.dart';
 import 'package:flutter/rendering.dart';
+import 'package:flutter/scheduler.dart';
 import 'package:flutter/services.dart';
 import 'package:context_menus/context_menus.dart';
 import 'package:super_clipboard/super_clipboard.dart';
 import 'package:super_drag_and_drop/super_drag_and_drop.dart';
 
 import '../webview_cef.dart';
+import 'blocking_stats.dart';
+import 'browser_command.dart';
+import 'cache_stats.dart';
 import 'cursor.dart';
+import 'input_ffi.dart';
+import 'load_policy.dart';
+import 'native_port.dart';
+import 'network_timing.dart';
+import 'performance_metrics.dart';
+import 'resource_usage.dart';
+import 'response_cache_stats.dart';
 
 class CommonContextMenu extends StatefulWidget {
   const CommonContextMenu({Key? key, required this.controller})
@@ -148,6 +160,98 @@ Future<void> shutdownCEF() async {
   await _pluginMethodChannel.invokeMethod("shutdown");
 }
 
+/// Returns the latest resource usage of every browser keyed by texture id.
+Future<Map<int, ResourceUsage>> getAllResourceUsage() async {
+  final result = await _pluginMethodChannel
+      .invokeMethod<Map<dynamic, dynamic>>('getResourceUsage');
+  return (result ?? {}).map((key, value) =>
+      MapEntry(key as int, ResourceUsage.fromMap(value as Map)));
+}
+
+/// Starts chrome tracing. Plugin events are recorded under the `dart_cef`
+/// category, empty [categories] record the chromium defaults.
+Future<void> startTracing({String categories = ""}) async {
+  await _pluginMethodChannel.invokeMethod('startTracing', categories);
+}
+
+/// Stops tracing and writes a chrome json trace to [path]. Returns the path
+/// of the written file.
+Future<String?> stopTracing({String path = ""}) async {
+  return _pluginMethodChannel.invokeMethod<String>('stopTracing', path);
+}
+
+/// Writes the plugin's in-memory event rings as a chrome json trace to
+/// [path]. Returns the number of records written.
+Future<int> dumpEventTrace(String path) async {
+  return await _pluginMethodChannel.invokeMethod<int>('dumpEventTrace', path) ??
+      0;
+}
+
+/// Dumps the event rings into [directory] whenever a frame takes longer than
+/// [threshold], [Duration.zero] disables automatic dumps.
+Future<void> setEventTraceSpikeDump(Duration threshold, String directory) async {
+  await _pluginMethodChannel.invokeMethod('setEventTraceSpikeDump', {
+    'thresholdMs': threshold.inMilliseconds,
+    'directory': directory,
+  });
+}
+
+/// Sets how often renderer processes are sampled, [Duration.zero] stops sampling.
+/// Sampling is off until this is called.
+Future<void> setResourceSamplingInterval(Duration interval) async {
+  await _pluginMethodChannel.invokeMethod(
+      'setResourceSamplingInterval', interval.inMilliseconds);
+}
+
+/// Serves the asset pack at [path] under `dartcef://assets/`, replacing a
+/// previously mounted pack. Packs are built with
+/// `dart run dart_cef:pack_assets`. Returns the number of files in the pack.
+Future<int> mountAssetPack(String path) async {
+  return await _pluginMethodChannel.invokeMethod<int>('mountAssetPack', path) ??
+      0;
+}
+
+/// Stores the profile of browsers created afterwards in [cachePath], relative
+/// paths are resolved against the root cache directory, which is returned.
+/// An empty path goes back to the default profile. CEF is initialized before
+/// Dart runs, so the root directory and the maximum cache size are set on
+/// the command line with `--dart-cef-root-cache-path` and
+/// `--dart-cef-cache-max-mb`.
+Future<String?> setCachePath(String cachePath) async {
+  return _pluginMethodChannel.invokeMethod<String>('setCachePath', cachePath);
+}
+
+/// Reports [WebviewController.cacheStats] for every page load of browsers
+/// created afterwards.
+Future<void> setCacheMetricsEnabled(bool enabled) async {
+  await _pluginMethodChannel.invokeMethod('setCacheMetricsEnabled', enabled);
+}
+
+/// Caches GET responses of urls starting with one of [urlPrefixes] in
+/// memory, shared by the webviews of a request context. Responses are kept
+/// while fresh per their Cache-Control header, concurrent requests for the
+/// same url share one fetch. Requests with an Authorization header, event
+/// streams, responses without a Content-Length or above a quarter of
+/// [maxBytes] and redirects are not cached. A [maxBytes] of 0 or no
+/// [urlPrefixes] disable the cache, every call drops the cached responses.
+Future<void> setResponseCache(
+    {required int maxBytes, required List<String> urlPrefixes}) async {
+  await _pluginMethodChannel.invokeMethod('setResponseCache',
+      <String, dynamic>{'maxBytes': maxBytes, 'urlPrefixes': urlPrefixes});
+}
+
+Future<ResponseCacheStats> getResponseCacheStats() async {
+  final stats = await _pluginMethodChannel
+      .invokeMethod<Map<dynamic, dynamic>>('getResponseCacheStats');
+  return ResponseCacheStats.fromMap(stats ?? const {});
+}
+
+/// Sets the minimum level of the plugin's log messages. Debug messages are
+/// only available in debug builds of the plugin.
+Future<void> setLogLevel(LogLevel level) async {
+  await _pluginMethodChannel.invokeMethod('setLogLevel', level.name);
+}
+
 class CefRect {
   int x;
   int y;
@@ -219,21 +323,85 @@ class WebviewController extends ValueNotifier<bool> {
       StreamController<WebviewEvent>.broadcast();
   Stream<WebviewEvent> get browserEvents => _browserEventsController.stream;
 
+  final StreamController<PerformanceMetrics> _performanceMetricsController =
+      StreamController<PerformanceMetrics>.broadcast();
+  Stream<PerformanceMetrics> get performanceMetrics =>
+      _performanceMetricsController.stream;
+
+  final StreamController<CacheStats> _cacheStatsController =
+      StreamController<CacheStats>.broadcast();
+  Stream<CacheStats> get cacheStats => _cacheStatsController.stream;
+
+  final StreamController<NetworkTiming> _networkTimingController =
+      StreamController<NetworkTiming>.broadcast();
+
+  /// Request timings of every page load, see [setNetworkTimingEnabled].
+  Stream<NetworkTiming> get networkTiming => _networkTimingController.stream;
+
+  final StreamController<Duration> _eventProbeController =
+      StreamController<Duration>.broadcast();
+
+  /// Time from sending to receiving each probe of [sendEventProbes].
+  Stream<Duration> get eventProbeLatency => _eventProbeController.stream;
+
+  ReceivePort? _eventPort;
+
+  // layout updates collected during a frame, sent as one batch after it
+  final List<BrowserCommand> _pendingCommands = [];
+
   WebviewController() : super(false);
 
   Future<void> get ready => _creatingCompleter.future;
 
+  /// Identifies the browser in the plugin's channels and C entry points.
+  int get textureId => _textureId;
+
+  InputRing? _inputRing;
+
+  /// Shared memory input queue, null where the ffi entry points are missing.
+  InputRing? get _ring =>
+      _inputRing ??= InputFfi.instance?.ring(_textureId);
+
   /// Initializes the underlying platform view.
+  ///
+  /// Webviews created with the same [contextKey] share cookies, storage and
+  /// caches, webviews with different keys are isolated from each other. The
+  /// context is kept on disk if [persistContext] is set and in memory
+  /// otherwise. The empty key uses the default profile.
+  ///
+  /// [token] and [accessToken] are readable by the page's main frame as
+  /// `window.dartCefTokens.token` and `window.dartCefTokens.access_token`.
+  ///
+  /// [initialSize] is the logical size of the webview if known, the first
+  /// page is laid out at it instead of waiting for the widget's layout.
+  /// [devicePixelRatio] defaults to the window's, the [Webview] widget
+  /// follows later changes with [setDevicePixelRatio].
+  ///
+  /// With [compositePopup] popups such as select dropdowns are drawn into
+  /// the page texture natively, [showPopup] and [popupRect] stay silent.
+  ///
+  /// With [nativeEvents] the browser posts its events straight to a
+  /// [ReceivePort] instead of the event channel, where the platform supports
+  /// it.
   Future<void> initialize(
       {String startUrl = "about:blank",
       String webMessageFunction = "postMessage",
       bool isHTML = false,
       String token = "",
-      String accessToken = ""}) async {
+      String accessToken = "",
+      String contextKey = "",
+      bool persistContext = false,
+      bool nativeEvents = false,
+      bool compositePopup = false,
+      Size? initialSize,
+      double? devicePixelRatio}) async {
     if (_isDisposed || value) {
       return Future<void>.value();
     }
     _creatingCompleter = Completer<void>();
+    if (nativeEvents && NativeEventPort.isAvailable) {
+      _eventPort = ReceivePort();
+    }
     try {
       _textureId = await _pluginMethodChannel
               .invokeMethod<int>('createBrowser', <String, dynamic>{
@@ -241,77 +409,31 @@ class WebviewController extends ValueNotifier<bool> {
             'webMessageFunction': webMessageFunction,
             'isHTML': isHTML,
             'token': token,
-            'accessToken': accessToken
+            'accessToken': accessToken,
+            'contextKey': contextKey,
+            'persistContext': persistContext,
+            'eventPort': _eventPort?.sendPort.nativePort,
+            'compositePopup': compositePopup,
+            if (initialSize != null && !initialSize.isEmpty) ...{
+              'width': initialSize.width.round(),
+              'height': initialSize.height.round(),
+            },
+            'devicePixelRatio': devicePixelRatio ??
+                WidgetsBinding.instance.window.devicePixelRatio
           }) ??
           0;
       _methodChannel = MethodChannel('$_pluginChannelPrefix/$_textureId');
       _eventChannel = EventChannel('$_pluginChannelPrefix/$_textureId/events');
-      _eventChannel.receiveBroadcastStream().listen((event) async {
-        final map = event as Map<dynamic, dynamic>;
-        switch (map['type']) {
-          case 'browserEvent':
-            final event = WebviewEvent.values[map['value']];
-            _browserEventsController.add(event);
-            break;
-          case 'loadingState':
-            final state = LoadingState.values[map['value']];
-            _loadingStateStreamController.add(state);
-            break;
-          case 'textSelectionReport':
-            _textSelectionController.add(map["value"]);
-            break;
-          case "browserState":
-            final state = WebviewState.values[map['value']];
-            if (state == WebviewState.ready &&
-                !_creatingCompleter.isCompleted) {
-              _petTextureId =
-                  await _methodChannel.invokeMethod<int>('petTexture') ?? 0;
-              _creatingCompleter.complete();
-              value = true;
-              activeBrowsers++;
-            }
-            if (state == WebviewState.shutdown) {
-              activeBrowsers--;
-              if (_shuttingDownCompleter != null && activeBrowsers == 0) {
-                _shuttingDownCompleter!.complete();
-              }
-            }
-            _webviewStateStreamController.add(state);
-            break;
-          case "urlChanged":
-            _urlStreamController.add(map["value"]);
-            break;
-          case "popupShow":
-            if (map["value"] == false) {
-              _popRectController.add(null);
-            }
-            _popShowController.add(map["value"]);
-            break;
-          case "popupSize":
-            _popRectController.add(CefRect(
-                x: map["x"],
-                y: map["y"],
-                width: map["width"],
-                height: map["height"]));
-            break;
-          case 'titleChanged':
-            _titleStreamController.add(map['value']);
-            break;
-          case 'cursorChanged':
-            _cursorStreamController.add(getCursorByName(map['value']));
-            break;
-          case 'showContextMenu':
-            _contextMenuShowController.add(true);
-            break;
-          case 'webMessage':
-            try {
-              final message = json.decode(map['value']);
-              _webMessageStreamController.add(message);
-            } catch (ex) {
-              _webMessageStreamController.addError(ex);
-            }
-        }
-      });
+      final eventPort = _eventPort;
+      final events = _eventChannel.receiveBroadcastStream();
+      if (eventPort != null) {
+        // the subscription still starts the browser, events arrive on the port
+        events.listen((_) {});
+        eventPort
+            .listen((message) => _onEvent(NativeEventPort.decode(message)));
+      } else {
+        events.listen(_onEvent);
+      }
     } on PlatformException catch (e) {
       _creatingCompleter.completeError(e);
     }
@@ -319,12 +441,100 @@ class WebviewController extends ValueNotifier<bool> {
     return _creatingCompleter.future;
   }
 
+  Future<void> _onEvent(dynamic event) async {
+    final map = event as Map<dynamic, dynamic>;
+    switch (map['type']) {
+      case 'browserEvent':
+        final event = WebviewEvent.values[map['value']];
+        _browserEventsController.add(event);
+        break;
+      case 'loadingState':
+        final state = LoadingState.values[map['value']];
+        _loadingStateStreamController.add(state);
+        break;
+      case 'textSelectionReport':
+        _textSelectionController.add(map["value"]);
+        break;
+      case "browserState":
+        final state = WebviewState.values[map['value']];
+        if (state == WebviewState.ready &&
+            !_creatingCompleter.isCompleted) {
+          _petTextureId =
+              await _methodChannel.invokeMethod<int>('petTexture') ?? 0;
+          _creatingCompleter.complete();
+          value = true;
+          activeBrowsers++;
+        }
+        if (state == WebviewState.shutdown) {
+          activeBrowsers--;
+          if (_shuttingDownCompleter != null && activeBrowsers == 0) {
+            _shuttingDownCompleter!.complete();
+          }
+        }
+        _webviewStateStreamController.add(state);
+        break;
+      case "urlChanged":
+        _urlStreamController.add(map["value"]);
+        break;
+      case "popupShow":
+        // the popup texture is created on demand and may change
+        if (map["texture"] != null) {
+          _petTextureId = map["texture"];
+        }
+        if (map["value"] == false) {
+          _popRectController.add(null);
+        }
+        _popShowController.add(map["value"]);
+        break;
+      case "popupSize":
+        _popRectController.add(CefRect(
+            x: map["x"],
+            y: map["y"],
+            width: map["width"],
+            height: map["height"]));
+        break;
+      case 'titleChanged':
+        _titleStreamController.add(map['value']);
+        break;
+      case 'cursorChanged':
+        _cursorStreamController.add(getCursorByName(map['value']));
+        break;
+      case 'showContextMenu':
+        _contextMenuShowController.add(true);
+        break;
+      case 'cacheStats':
+        _cacheStatsController.add(CacheStats.fromMap(map['value']));
+        break;
+      case 'networkTiming':
+        _networkTimingController.add(NetworkTiming.fromMap(map['value']));
+        break;
+      case 'eventProbe':
+        final sentUs = map['value'] as int;
+        _eventProbeController.add(Duration(
+            microseconds: DateTime.now().microsecondsSinceEpoch - sentUs));
+        break;
+      case 'performanceMetrics':
+        _performanceMetricsController.add(PerformanceMetrics.fromList(
+            List<double>.from(map['value'])));
+        break;
+      case 'webMessage':
+        try {
+          final message = json.decode(map['value']);
+          _webMessageStreamController.add(message);
+        } catch (ex) {
+          _webMessageStreamController.addError(ex);
+        }
+    }
+  }
+
   @override
   Future<void> dispose() async {
     await _creatingCompleter.future;
     if (!_isDisposed) {
       _isDisposed = true;
+      _inputRing?.destroy();
       await _methodChannel.invokeMethod('closeBrowser', true);
+      _eventPort?.close();
     }
     super.dispose();
   }
@@ -338,6 +548,47 @@ class WebviewController extends ValueNotifier<bool> {
     return _methodChannel.invokeMethod('loadUrl', url);
   }
 
+  /// Paints the page at [scale] of the display resolution, from 0.25 to 1.
+  /// Lower values rasterize fewer pixels and are stretched to the widget,
+  /// see [ResourceUsage.rasterPixelsPerSecond].
+  Future<void> setRenderScale(double scale) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('setRenderScale', scale);
+  }
+
+  /// Paints the page at [ratio] device pixels per logical pixel. Called by
+  /// the [Webview] widget when its [MediaQueryData.devicePixelRatio] changes.
+  Future<void> setDevicePixelRatio(double ratio) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('setDevicePixelRatio', ratio);
+  }
+
+  /// Sends [count] probe events from the CEF UI thread, their delivery
+  /// delay is reported by [eventProbeLatency].
+  Future<void> sendEventProbes(int count) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('sendEventProbes', count);
+  }
+
+  /// Loads [url] in the background, a later [loadUrl] of the same url shows
+  /// it right away. Replaces an earlier prerender, an empty url drops it.
+  Future<void> prerender(String url) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('prerender', url);
+  }
+
   Future<void> loadHTML(String text) async {
     if (_isDisposed) {
       return;
@@ -351,7 +602,33 @@ class WebviewController extends ValueNotifier<bool> {
       return;
     }
     assert(value);
-    return _methodChannel.invokeMethod('setZoomLevel', level);
+    return applyBatch([BrowserCommand.zoomLevel(level)]);
+  }
+
+  /// Applies [commands] in order in one step on the browser thread, the
+  /// browser is resized at most once. Completes when all of them took
+  /// effect, nothing is applied if one of them is invalid.
+  Future<void> applyBatch(List<BrowserCommand> commands) async {
+    if (_isDisposed || !value || commands.isEmpty) {
+      return;
+    }
+    await _methodChannel.invokeMethod(
+        'applyBatch', commands.map((command) => command.toList()).toList());
+  }
+
+  /// Queues [command] for the batch sent after the current frame, replacing
+  /// a queued command of the same kind.
+  void _queueCommand(BrowserCommand command) {
+    if (_pendingCommands.isEmpty) {
+      SchedulerBinding.instance.addPostFrameCallback((_) {
+        final commands = List<BrowserCommand>.of(_pendingCommands);
+        _pendingCommands.clear();
+        unawaited(applyBatch(commands));
+      });
+      SchedulerBinding.instance.ensureVisualUpdate();
+    }
+    _pendingCommands.removeWhere((queued) => queued.name == command.name);
+    _pendingCommands.add(command);
   }
 
   Future<void> getTextSelectionReport() async {
@@ -362,6 +639,69 @@ class WebviewController extends ValueNotifier<bool> {
     return _methodChannel.invokeMethod('getTextSelectionReport');
   }
 
+  Future<ResourceUsage?> getResourceUsage() async {
+    if (_isDisposed) {
+      return null;
+    }
+    assert(value);
+    final usage = await _methodChannel
+        .invokeMethod<Map<dynamic, dynamic>>('getResourceUsage');
+    return usage == null ? null : ResourceUsage.fromMap(usage);
+  }
+
+  /// Collects DevTools performance metrics every [interval] and emits them on
+  /// [performanceMetrics], [Duration.zero] stops collecting.
+  Future<void> setPerformanceMetricsInterval(Duration interval) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod(
+        'setPerformanceMetricsInterval', interval.inMilliseconds);
+  }
+
+  /// Blocks subresource requests of this browser matching [rules], given as
+  /// an EasyList style filter list or a plain list of hosts. An empty string
+  /// removes blocking. Returns the number of rules in use.
+  Future<int> setBlockList(String rules) async {
+    if (_isDisposed) {
+      return 0;
+    }
+    assert(value);
+    return await _methodChannel.invokeMethod<int>('setBlockList', rules) ?? 0;
+  }
+
+  /// Replaces the load policy of this browser, requests deferred under the
+  /// previous policy are started right away.
+  Future<void> setLoadPolicy(LoadPolicy policy) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('setLoadPolicy', policy.toMap());
+  }
+
+  /// Starts or stops recording the timing of this browser's requests,
+  /// reported on [networkTiming] when a page load completes.
+  Future<void> setNetworkTimingEnabled(bool enabled) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('setNetworkTimingEnabled', enabled);
+  }
+
+  Future<BlockingStats?> getBlockingStats() async {
+    if (_isDisposed) {
+      return null;
+    }
+    assert(value);
+    final stats = await _methodChannel
+        .invokeMethod<Map<dynamic, dynamic>>('getBlockingStats');
+    return stats == null ? null : BlockingStats.fromMap(stats);
+  }
+
+  /// Clears the cookies of this webview's context, see [initialize].
   Future<void> clearAllCookies() async {
     if (_isDisposed) {
       return;
@@ -387,6 +727,7 @@ class WebviewController extends ValueNotifier<bool> {
     return _methodChannel.invokeMethod('executeJavaScript', js);
   }
 
+  /// Updates the token pages read from `window.dartCefTokens.token`.
   Future<void> setToken(String token) async {
     if (_isDisposed) {
       return;
@@ -427,6 +768,7 @@ class WebviewController extends ValueNotifier<bool> {
     return _methodChannel.invokeMethod('onDrop');
   }
 
+  /// Updates the token pages read from `window.dartCefTokens.access_token`.
   Future<void> setAccessToken(String token) async {
     if (_isDisposed) {
       return;
@@ -443,6 +785,18 @@ class WebviewController extends ValueNotifier<bool> {
     return _methodChannel.invokeMethod('reload', ignoreCache);
   }
 
+  /// Frame buffers of a hidden browser are freed after a few seconds. With a
+  /// [divisor] of 2 to 8 a frame downscaled by it is kept and shown until the
+  /// page repaints after [setHidden] false, 0 keeps nothing. See
+  /// [ResourceUsage.releasedBufferBytes].
+  Future<void> setHiddenSnapshot(int divisor) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value);
+    return _methodChannel.invokeMethod('setHiddenSnapshot', divisor);
+  }
+
   Future<void> setHidden(bool hidden) async {
     if (_isDisposed) {
       return;
@@ -494,29 +848,32 @@ class WebviewController extends ValueNotifier<bool> {
   }
 
   /// Sets the surface size to the provided [size].
-  Future<void> _setSize(Size size) async {
+  void _setSize(Size size) {
     if (_isDisposed) {
       return;
     }
     assert(value);
-    return _methodChannel
-        .invokeMethod('setSize', [size.width.round(), size.height.round()]);
+    _queueCommand(BrowserCommand.size(size));
   }
 
-  Future<void> _setOffset(Offset offset) async {
+  void _setOffset(Offset offset) {
     if (_isDisposed) {
       return;
     }
     assert(value);
-    return _methodChannel
-        .invokeMethod('setOffset', [offset.dx.round(), offset.dy.round()]);
+    _queueCommand(BrowserCommand.offset(offset));
   }
 
-  Future<void> _setScrollDelta(int dx, int dy) async {
+  Future<void> _setScrollDelta(int dx, int dy,
+      [Offset position = Offset.zero]) async {
     if (_isDisposed) {
       return;
     }
     assert(value);
+    if (_ring?.wheel(position.dx.round(), position.dy.round(), dx, dy, 0) ??
+        false) {
+      return;
+    }
     return _methodChannel.invokeMethod('setScrollDelta', [dx, dy]);
   }
 
@@ -525,10 +882,42 @@ class WebviewController extends ValueNotifier<bool> {
       return;
     }
     assert(value);
+    if (_ring?.click(position.dx.round(), position.dy.round(),
+            MouseButton.left, false, 1, 0) ??
+        false) {
+      return;
+    }
     return _methodChannel.invokeMethod(
         'cursorClickDown', [position.dx.round(), position.dy.round()]);
   }
 
+  /// Moves the mouse to [position], [buttons] are the Flutter pointer
+  /// buttons held down while dragging.
+  void _sendPointerMove(Offset position, int buttons) {
+    if (_isDisposed || !value) {
+      return;
+    }
+    final ring = _ring;
+    if (ring != null) {
+      var modifiers = 0;
+      if (buttons & kPrimaryButton != 0) {
+        modifiers |= InputModifiers.leftButton;
+      }
+      if (buttons & kSecondaryButton != 0) {
+        modifiers |= InputModifiers.rightButton;
+      }
+      if (buttons & kMiddleMouseButton != 0) {
+        modifiers |= InputModifiers.middleButton;
+      }
+      // a full ring drops the move rather than passing earlier clicks on the
+      // method channel, the next move carries the position
+      ring.move(position.dx.round(), position.dy.round(), modifiers);
+      return;
+    }
+    _methodChannel.invokeMethod('setCursorPos',
+        <String, int>{'x': position.dx.round(), 'y': position.dy.round()});
+  }
+
   Future<void> updateOffset() async {
     if (_isDisposed) {
       return;
@@ -537,8 +926,7 @@ class WebviewController extends ValueNotifier<bool> {
     var bounds = key.globalPaintBounds;
     var offset = bounds?.topLeft;
     if (offset != null) {
-      return _methodChannel
-          .invokeMethod('setOffset', [offset.dx.round(), offset.dy.round()]);
+      return applyBatch([BrowserCommand.offset(offset)]);
     }
   }
 }
@@ -567,6 +955,8 @@ class _WebviewState extends State<Webview> {
 
   var dropEntered = false;
 
+  double? _devicePixelRatio;
+
   @override
   void initState() {
     super.initState();
@@ -586,12 +976,23 @@ class _WebviewState extends State<Webview> {
     });
   }
 
+  @override
+  void didChangeDependencies() {
+    super.didChangeDependencies();
+    final ratio = MediaQuery.of(context).devicePixelRatio;
+    // the browser was created at the first ratio
+    if (_devicePixelRatio != null && ratio != _devicePixelRatio) {
+      _controller.setDevicePixelRatio(ratio);
+    }
+    _devicePixelRatio = ratio;
+  }
+
   @override
   void dispose() async {
     _cursorSubscription?.cancel();
     _textSelectionSubscription?.cancel();
-    _controller.setHidden(true);
-    _controller.setCurrent(false);
+    _controller.applyBatch(
+        [BrowserCommand.hidden(true), BrowserCommand.current(false)]);
     super.dispose();
   }
 
@@ -636,9 +1037,13 @@ class _WebviewState extends State<Webview> {
             onPointerSignal: (signal) {
               if (signal is PointerScrollEvent) {
                 _controller._setScrollDelta(-signal.scrollDelta.dx.round(),
-                    -signal.scrollDelta.dy.round());
+                    -signal.scrollDelta.dy.round(), signal.localPosition);
               }
             },
+            onPointerHover: (ev) =>
+                _controller._sendPointerMove(ev.localPosition, ev.buttons),
+            onPointerMove: (ev) =>
+                _controller._sendPointerMove(ev.localPosition, ev.buttons),
             onPointerDown: (ev) {
               if (!webViewFocus.hasFocus) {
                 webViewFocus.requestFocus();
@@ -774,11 +1179,11 @@ class _WebviewCoreState extends State<WebviewCore> {
         if (size.width == 0 || size.height == 0) {
           return;
         }
-        unawaited(widget._controller._setSize(size));
+        widget._controller._setSize(size);
       }),
       onPositionChange: (Offset position) async {
         await widget._controller.ready;
-        unawaited(widget._controller._setOffset(position));
+        widget._controller._setOffset(position);
       },
       child: Stack(
         key: widget._controller.key,
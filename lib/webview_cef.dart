@@ -1,2 +1,12 @@
 export 'src/webview.dart';
-export 'src/enums.dart';
\ No newline at end of file
+export 'src/enums.dart';
+export 'src/blocking_stats.dart';
+export 'src/browser_command.dart';
+export 'src/cache_stats.dart';
+export 'src/input_ffi.dart';
+export 'src/load_policy.dart';
+export 'src/native_port.dart';
+export 'src/network_timing.dart';
+export 'src/resource_usage.dart';
+export 'src/response_cache_stats.dart';
+export 'src/performance_metrics.dart';
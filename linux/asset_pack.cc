@@ -0,0 +1,340 @@
+#include "asset_pack.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/cef_parser.h"
+#include "include/cef_resource_handler.h"
+
+#include "async_log.h"
+
+namespace asset_pack
+{
+  namespace
+  {
+    constexpr char kMagic[4] = {'D', 'C', 'P', 'K'};
+
+    constexpr size_t kHeaderSize = 16;
+
+    std::mutex g_mutex;
+
+    std::shared_ptr<Pack> g_pack;
+
+    std::shared_ptr<Pack> CurrentPack()
+    {
+      std::lock_guard<std::mutex> lock(g_mutex);
+      return g_pack;
+    }
+
+    // Parses a single "bytes=first-last" range, both ends inclusive. Returns
+    // false for anything we don't support, the full body is sent then.
+    bool ParseRange(const std::string &header, uint64_t size, uint64_t &first, uint64_t &last)
+    {
+      constexpr std::string_view kPrefix = "bytes=";
+      if (header.compare(0, kPrefix.size(), kPrefix) != 0 || header.find(',') != std::string::npos)
+      {
+        return false;
+      }
+      const std::string spec = header.substr(kPrefix.size());
+      const auto dash = spec.find('-');
+      if (dash == std::string::npos)
+      {
+        return false;
+      }
+      const std::string start = spec.substr(0, dash);
+      const std::string end = spec.substr(dash + 1);
+      try
+      {
+        if (start.empty())
+        {
+          // suffix range, the last n bytes
+          const uint64_t length = std::stoull(end);
+          if (length == 0)
+          {
+            return false;
+          }
+          first = length >= size ? 0 : size - length;
+          last = size - 1;
+        }
+        else
+        {
+          first = std::stoull(start);
+          last = end.empty() ? size - 1 : std::min<uint64_t>(std::stoull(end), size - 1);
+        }
+      }
+      catch (const std::exception &)
+      {
+        return false;
+      }
+      return first <= last;
+    }
+
+    class AssetResourceHandler : public CefResourceHandler
+    {
+    public:
+      AssetResourceHandler(std::shared_ptr<Pack> pack, const Entry *entry)
+          : pack_(std::move(pack)), entry_(entry) {}
+
+      bool Open(CefRefPtr<CefRequest> request,
+                bool &handle_request,
+                CefRefPtr<CefCallback> callback) override
+      {
+        handle_request = true;
+        const uint64_t size = entry_->data_length;
+        const std::string etag(pack_->ETag(*entry_));
+
+        if (!etag.empty() && request->GetHeaderByName("If-None-Match").ToString() == etag)
+        {
+          status_ = 304;
+          return true;
+        }
+
+        const std::string range = request->GetHeaderByName("Range");
+        uint64_t first = 0;
+        uint64_t last = 0;
+        if (!range.empty() && size > 0)
+        {
+          if (!ParseRange(range, size, first, last) || first >= size)
+          {
+            status_ = 416;
+            return true;
+          }
+          status_ = 206;
+          offset_ = first;
+          end_ = last + 1;
+          return true;
+        }
+        status_ = 200;
+        offset_ = 0;
+        end_ = size;
+        return true;
+      }
+
+      void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                              int64 &response_length,
+                              CefString &redirectUrl) override
+      {
+        const uint64_t size = entry_->data_length;
+        CefResponse::HeaderMap headers;
+        headers.emplace("Accept-Ranges", "bytes");
+        if (entry_->etag_length > 0)
+        {
+          headers.emplace("ETag", std::string(pack_->ETag(*entry_)));
+        }
+        response->SetStatus(status_);
+        response->SetMimeType(std::string(pack_->MimeType(*entry_)));
+        switch (status_)
+        {
+        case 206:
+          response->SetStatusText("Partial Content");
+          headers.emplace("Content-Range", "bytes " + std::to_string(offset_) + "-" + std::to_string(end_ - 1) + "/" + std::to_string(size));
+          break;
+        case 304:
+          response->SetStatusText("Not Modified");
+          break;
+        case 416:
+          response->SetStatusText("Range Not Satisfiable");
+          headers.emplace("Content-Range", "bytes */" + std::to_string(size));
+          break;
+        default:
+          response->SetStatusText("OK");
+          break;
+        }
+        response->SetHeaderMap(headers);
+        response_length = end_ - offset_;
+      }
+
+      bool Read(void *data_out,
+                int bytes_to_read,
+                int &bytes_read,
+                CefRefPtr<CefResourceReadCallback> callback) override
+      {
+        if (offset_ >= end_)
+        {
+          bytes_read = 0;
+          return false;
+        }
+        // the only copy, straight from the mapped pack into chromium's buffer
+        const uint64_t count = std::min<uint64_t>(end_ - offset_, bytes_to_read);
+        memcpy(data_out, pack_->Data(*entry_) + offset_, count);
+        offset_ += count;
+        bytes_read = static_cast<int>(count);
+        return true;
+      }
+
+      void Cancel() override {}
+
+    private:
+      std::shared_ptr<Pack> pack_;
+      const Entry *entry_;
+      int status_ = 200;
+      uint64_t offset_ = 0;
+      uint64_t end_ = 0;
+
+      IMPLEMENT_REFCOUNTING(AssetResourceHandler);
+      DISALLOW_COPY_AND_ASSIGN(AssetResourceHandler);
+    };
+
+    class AssetSchemeHandlerFactory : public CefSchemeHandlerFactory
+    {
+    public:
+      CefRefPtr<CefResourceHandler> Create(CefRefPtr<CefBrowser> browser,
+                                           CefRefPtr<CefFrame> frame,
+                                           const CefString &scheme_name,
+                                           CefRefPtr<CefRequest> request) override
+      {
+        auto pack = CurrentPack();
+        if (!pack)
+        {
+          return nullptr;
+        }
+        CefURLParts parts;
+        if (!CefParseURL(request->GetURL(), parts))
+        {
+          return nullptr;
+        }
+        std::string path = CefURIDecode(CefString(&parts.path), false,
+                                        static_cast<cef_uri_unescape_rule_t>(UU_SPACES | UU_URL_SPECIAL_CHARS_EXCEPT_PATH_SEPARATORS))
+                               .ToString();
+        if (!path.empty() && path.front() == '/')
+        {
+          path.erase(0, 1);
+        }
+        if (path.empty() || path.back() == '/')
+        {
+          path += "index.html";
+        }
+        const Entry *entry = pack->Find(path);
+        if (!entry)
+        {
+          return nullptr;
+        }
+        return new AssetResourceHandler(std::move(pack), entry);
+      }
+
+    private:
+      IMPLEMENT_REFCOUNTING(AssetSchemeHandlerFactory);
+    };
+  }
+
+  // static
+  std::shared_ptr<Pack> Pack::Open(const std::string &path, std::string &error)
+  {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      error = "can't open " + path + ": " + strerror(errno);
+      return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kHeaderSize)
+    {
+      close(fd);
+      error = path + " is too small for an asset pack";
+      return nullptr;
+    }
+    const size_t length = info.st_size;
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+      error = "can't map " + path + ": " + strerror(errno);
+      return nullptr;
+    }
+    const char *base = static_cast<const char *>(mapping);
+
+    uint32_t header[3];
+    memcpy(header, base + sizeof(kMagic), sizeof(header));
+    const uint32_t version = header[0];
+    const uint32_t count = header[1];
+    if (memcmp(base, kMagic, sizeof(kMagic)) != 0 || version != kVersion)
+    {
+      munmap(mapping, length);
+      error = path + " is not a version " + std::to_string(kVersion) + " asset pack";
+      return nullptr;
+    }
+    if (count > (length - kHeaderSize) / sizeof(Entry))
+    {
+      munmap(mapping, length);
+      error = path + " has a truncated index";
+      return nullptr;
+    }
+
+    // check every reference once, lookups and reads trust the index afterwards
+    const Entry *entries = reinterpret_cast<const Entry *>(base + kHeaderSize);
+    auto in_bounds = [length](uint64_t offset, uint64_t size)
+    {
+      return offset <= length && size <= length - offset;
+    };
+    for (uint32_t i = 0; i < count; i++)
+    {
+      const Entry &entry = entries[i];
+      if (!in_bounds(entry.path_offset, entry.path_length) ||
+          !in_bounds(entry.mime_offset, entry.mime_length) ||
+          !in_bounds(entry.etag_offset, entry.etag_length) ||
+          !in_bounds(entry.data_offset, entry.data_length))
+      {
+        munmap(mapping, length);
+        error = path + " references data outside of the file";
+        return nullptr;
+      }
+    }
+
+    // the index is touched on every lookup, the data only on demand
+    madvise(mapping, kHeaderSize + count * sizeof(Entry), MADV_WILLNEED);
+    return std::shared_ptr<Pack>(new Pack(base, length, count));
+  }
+
+  Pack::Pack(const char *base, size_t length, uint32_t count)
+      : base_(base), length_(length), count_(count),
+        entries_(reinterpret_cast<const Entry *>(base + kHeaderSize))
+  {
+  }
+
+  Pack::~Pack()
+  {
+    munmap(const_cast<char *>(base_), length_);
+  }
+
+  const Entry *Pack::Find(std::string_view path) const
+  {
+    const Entry *end = entries_ + count_;
+    const Entry *it = std::lower_bound(entries_, end, path,
+                                       [this](const Entry &entry, std::string_view value)
+                                       { return Path(entry) < value; });
+    if (it == end || Path(*it) != path)
+    {
+      return nullptr;
+    }
+    return it;
+  }
+
+  int Mount(const std::string &path, std::string &error)
+  {
+    auto pack = Pack::Open(path, error);
+    if (!pack)
+    {
+      ALOG(Warning, "Failed to mount asset pack: {}", error);
+      return -1;
+    }
+    const int count = pack->size();
+    {
+      std::lock_guard<std::mutex> lock(g_mutex);
+      g_pack = std::move(pack);
+    }
+    ALOG(Info, "Mounted asset pack {} with {} entries", path, count);
+    return count;
+  }
+
+  CefRefPtr<CefSchemeHandlerFactory> CreateSchemeHandlerFactory()
+  {
+    return new AssetSchemeHandlerFactory();
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "include/cef_scheme.h"
+
+// Serves the app's web assets from a single memory-mapped pack file under
+// dartcef://assets/<path>. The pack is written by bin/pack_assets.dart:
+//
+//   header   "DCPK", u32 version, u32 entry count, u32 reserved
+//   entries  sorted by path, see Entry
+//   strings  paths, mime types and etags referenced by the entries
+//   data     file contents
+//
+// All integers are little endian and all offsets are relative to the start
+// of the file. Lookups are a binary search over the mapped index, file
+// contents are copied straight from the mapping into the network buffers.
+namespace asset_pack
+{
+  constexpr auto kHost = "assets";
+
+  constexpr uint32_t kVersion = 1;
+
+  struct Entry
+  {
+    uint32_t path_offset;
+    uint32_t path_length;
+    uint32_t mime_offset;
+    uint32_t mime_length;
+    uint32_t etag_offset;
+    uint32_t etag_length;
+    uint64_t data_offset;
+    uint64_t data_length;
+  };
+  static_assert(sizeof(Entry) == 40, "pack entries are 40 bytes");
+
+  class Pack
+  {
+  public:
+    // Maps |path| and validates its index, returns nullptr and sets |error|
+    // if the file can't be used.
+    static std::shared_ptr<Pack> Open(const std::string &path, std::string &error);
+
+    ~Pack();
+
+    uint32_t size() const { return count_; }
+
+    const Entry *Find(std::string_view path) const;
+
+    std::string_view Path(const Entry &entry) const { return String(entry.path_offset, entry.path_length); }
+    std::string_view MimeType(const Entry &entry) const { return String(entry.mime_offset, entry.mime_length); }
+    std::string_view ETag(const Entry &entry) const { return String(entry.etag_offset, entry.etag_length); }
+    const char *Data(const Entry &entry) const { return base_ + entry.data_offset; }
+
+  private:
+    Pack(const char *base, size_t length, uint32_t count);
+
+    std::string_view String(uint32_t offset, uint32_t length) const
+    {
+      return std::string_view(base_ + offset, length);
+    }
+
+    const char *base_;
+    size_t length_;
+    uint32_t count_;
+    const Entry *entries_;
+  };
+
+  // Replaces the mounted pack, requests already being served keep the old
+  // mapping alive. Returns the number of entries or -1 with |error| set.
+  int Mount(const std::string &path, std::string &error);
+
+  // Returns a new factory for CefRegisterSchemeHandlerFactory.
+  CefRefPtr<CefSchemeHandlerFactory> CreateSchemeHandlerFactory();
+}
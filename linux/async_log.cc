@@ -0,0 +1,335 @@
+#include "async_log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace async_log
+{
+  std::atomic<int> g_level{static_cast<int>(Level::Info)};
+
+  namespace
+  {
+    // must be a power of two
+    constexpr size_t kQueueSize = 1024;
+
+    // how long the writer sleeps when the queue is empty
+    constexpr auto kWriterInterval = std::chrono::milliseconds(50);
+
+    struct Slot
+    {
+      std::atomic<size_t> sequence;
+      Level level;
+      int line;
+      const char *file;
+      long thread_id;
+      int64_t timestamp_us;
+      size_t length;
+      char text[kMaxMessage];
+    };
+
+    const char *LevelName(Level level)
+    {
+      switch (level)
+      {
+      case Level::Debug:
+        return "VERBOSE";
+      case Level::Info:
+        return "INFO";
+      case Level::Warning:
+        return "WARNING";
+      case Level::Error:
+        return "ERROR";
+      default:
+        return "";
+      }
+    }
+
+    const char *BaseName(const char *path)
+    {
+      const char *slash = strrchr(path, '/');
+      return slash ? slash + 1 : path;
+    }
+
+    int64_t NowMicros()
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+          .count();
+    }
+
+    class Logger;
+
+    Logger &GetLogger();
+
+    // Bounded multi-producer queue (Vyukov), drained by the single writer.
+    class Logger
+    {
+    public:
+      Logger()
+      {
+        ResetQueue();
+        pthread_atfork(&Logger::BeforeFork, &Logger::AfterForkInParent, &Logger::AfterForkInChild);
+      }
+
+      ~Logger()
+      {
+        Stop();
+      }
+
+      void Start(const std::string &path)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ >= 0)
+        {
+          return;
+        }
+        // shared with the chromium log, O_APPEND keeps single writes intact
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        // the writer starts with the first message, the zygote forks
+        // renderers after Init and a thread would not survive the fork
+      }
+
+      void Stop()
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          running_ = false;
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+          thread_.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        writer_started_.store(false, std::memory_order_release);
+        if (fd_ >= 0)
+        {
+          Drain();
+          close(fd_);
+          fd_ = -1;
+        }
+      }
+
+      void Push(Level level, const char *file, int line, const char *text, size_t length)
+      {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+          slot = &slots_[pos & (kQueueSize - 1)];
+          const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+          const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+          if (diff == 0)
+          {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+          else if (diff < 0)
+          {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+          }
+          else
+          {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+          }
+        }
+        slot->level = level;
+        slot->file = file;
+        slot->line = line;
+        slot->thread_id = syscall(SYS_gettid);
+        slot->timestamp_us = NowMicros();
+        slot->length = length;
+        memcpy(slot->text, text, length);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        if (!writer_started_.load(std::memory_order_acquire))
+        {
+          StartWriter();
+        }
+      }
+
+    private:
+      void StartWriter()
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (writer_started_.load(std::memory_order_relaxed) || fd_ < 0)
+        {
+          return;
+        }
+        running_ = true;
+        thread_ = std::thread(&Logger::Run, this);
+        writer_started_.store(true, std::memory_order_release);
+      }
+
+      void ResetQueue()
+      {
+        for (size_t i = 0; i < kQueueSize; i++)
+        {
+          slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_ = 0;
+        dropped_.store(0, std::memory_order_relaxed);
+      }
+
+      // Holding |mutex_| across fork keeps the writer out of it, so the child
+      // gets it unlocked.
+      static void BeforeFork()
+      {
+        GetLogger().mutex_.lock();
+      }
+
+      static void AfterForkInParent()
+      {
+        GetLogger().mutex_.unlock();
+      }
+
+      // The child has no writer thread. The queue is reset because it holds the
+      // parent's messages and maybe slots claimed by threads that are gone.
+      static void AfterForkInChild()
+      {
+        Logger &logger = GetLogger();
+        logger.pid_ = getpid();
+        logger.ResetQueue();
+        logger.running_ = false;
+        logger.writer_started_.store(false, std::memory_order_relaxed);
+        // the parent's thread and waiters don't exist here, replace the
+        // objects without destroying them
+        new (&logger.thread_) std::thread();
+        new (&logger.cv_) std::condition_variable();
+        logger.mutex_.unlock();
+      }
+
+      void Run()
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_)
+        {
+          Drain();
+          cv_.wait_for(lock, kWriterInterval, [this]
+                       { return !running_; });
+        }
+      }
+
+      // Writes all queued messages with one write call. |mutex_| must be held.
+      void Drain()
+      {
+        std::string batch;
+        const size_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+          batch += fmt::format("[{}:{}:WARNING:async_log.cc] {} log messages dropped\n", pid_, pid_, dropped);
+        }
+        for (;;)
+        {
+          Slot *slot = &slots_[dequeue_pos_ & (kQueueSize - 1)];
+          if (slot->sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+          {
+            break;
+          }
+          AppendLine(batch, *slot);
+          slot->sequence.store(dequeue_pos_ + kQueueSize, std::memory_order_release);
+          dequeue_pos_++;
+        }
+        if (!batch.empty() && write(fd_, batch.data(), batch.size()) < 0)
+        {
+          // nowhere left to report it
+        }
+      }
+
+      // Same layout as chromium log lines, the file is shared with CEF.
+      void AppendLine(std::string &batch, const Slot &slot)
+      {
+        const time_t seconds = slot.timestamp_us / 1000000;
+        struct tm local;
+        localtime_r(&seconds, &local);
+        batch += fmt::format("[{}:{}:{:02}{:02}/{:02}{:02}{:02}.{:06}:{}:{}({})] ",
+                             pid_, slot.thread_id,
+                             local.tm_mon + 1, local.tm_mday,
+                             local.tm_hour, local.tm_min, local.tm_sec,
+                             slot.timestamp_us % 1000000,
+                             LevelName(slot.level), BaseName(slot.file), slot.line);
+        batch.append(slot.text, slot.length);
+        batch += '\n';
+      }
+
+      Slot slots_[kQueueSize];
+      std::atomic<size_t> enqueue_pos_{0};
+      size_t dequeue_pos_ = 0;
+      std::atomic<size_t> dropped_{0};
+
+      int pid_ = getpid();
+      int fd_ = -1;
+      bool running_ = false;
+      std::atomic<bool> writer_started_{false};
+      std::mutex mutex_;
+      std::condition_variable cv_;
+      std::thread thread_;
+    };
+
+    Logger &GetLogger()
+    {
+      static Logger logger;
+      return logger;
+    }
+  }
+
+  void Init(const std::string &path, Level level)
+  {
+    SetLevel(level);
+    GetLogger().Start(path);
+  }
+
+  void SetLevel(Level level)
+  {
+    g_level.store(static_cast<int>(level), std::memory_order_relaxed);
+  }
+
+  Level ParseLevel(const std::string &name, Level fallback)
+  {
+    if (name == "debug")
+      return Level::Debug;
+    if (name == "info")
+      return Level::Info;
+    if (name == "warning")
+      return Level::Warning;
+    if (name == "error")
+      return Level::Error;
+    if (name == "none")
+      return Level::None;
+    return fallback;
+  }
+
+  void Shutdown()
+  {
+    GetLogger().Stop();
+  }
+
+  void Push(Level level, const char *file, int line, const char *text, size_t length)
+  {
+    GetLogger().Push(level, file, line, text, length);
+  }
+
+  bool RateLimiter::Allow(int interval_ms)
+  {
+    const int64_t now = NowMicros() / 1000;
+    int64_t next = next_ms_.load(std::memory_order_relaxed);
+    if (now < next)
+    {
+      return false;
+    }
+    return next_ms_.compare_exchange_strong(next, now + interval_ms, std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <fmt/core.h>
+
+// Logging for the plugin's own code. Messages are formatted into a fixed
+// buffer on the calling thread and pushed into a bounded lock-free queue,
+// a background thread appends them to the log file. Levels below
+// DART_CEF_LOG_COMPILED_LEVEL are removed at compile time, the runtime level
+// filters the rest. When the queue is full messages are dropped and counted.
+//
+//   ALOG(Info, "created browser {}", id);
+//   ALOG_EVERY_MS(Debug, 1000, "paint {}x{}", width, height);
+namespace async_log
+{
+  enum class Level : int
+  {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3,
+    None = 4,
+  };
+
+#ifndef DART_CEF_LOG_COMPILED_LEVEL
+#define DART_CEF_LOG_COMPILED_LEVEL 1
+#endif
+
+  constexpr int kCompiledLevel = DART_CEF_LOG_COMPILED_LEVEL;
+
+  // longest message kept, longer ones are truncated
+  constexpr size_t kMaxMessage = 232;
+
+  extern std::atomic<int> g_level;
+
+  inline bool IsOn(Level level)
+  {
+    return static_cast<int>(level) >= g_level.load(std::memory_order_relaxed);
+  }
+
+  // Opens |path| in append mode. The writer thread starts with the first
+  // message of each process, forked children start their own. Safe to call
+  // once per process, later calls only change the level.
+  void Init(const std::string &path, Level level);
+
+  void SetLevel(Level level);
+
+  // Parses "debug", "info", "warning", "error" or "none", |fallback| otherwise.
+  Level ParseLevel(const std::string &name, Level fallback);
+
+  // Drains the queue and stops the writer thread.
+  void Shutdown();
+
+  void Push(Level level, const char *file, int line, const char *text, size_t length);
+
+  template <typename... Args>
+  void Write(Level level, const char *file, int line, fmt::format_string<Args...> format, Args &&...args)
+  {
+    char buffer[kMaxMessage];
+    const auto result = fmt::format_to_n(buffer, sizeof(buffer), format, std::forward<Args>(args)...);
+    Push(level, file, line, buffer, std::min(result.size, sizeof(buffer)));
+  }
+
+  // Lets one message through per interval, one instance per call site.
+  class RateLimiter
+  {
+  public:
+    bool Allow(int interval_ms);
+
+  private:
+    std::atomic<int64_t> next_ms_{0};
+  };
+}
+
+#define ALOG_IS_ON(level)                                                         \
+  (static_cast<int>(async_log::Level::level) >= async_log::kCompiledLevel && \
+   async_log::IsOn(async_log::Level::level))
+
+#define ALOG(level, ...)                                                             \
+  do                                                                                 \
+  {                                                                                  \
+    if (ALOG_IS_ON(level))                                                           \
+      async_log::Write(async_log::Level::level, __FILE__, __LINE__, __VA_ARGS__); \
+  } while (0)
+
+#define ALOG_EVERY_MS(level, interval_ms, ...)                                         \
+  do                                                                                   \
+  {                                                                                    \
+    static async_log::RateLimiter alog_rate_limiter;                                   \
+    if (ALOG_IS_ON(level) && alog_rate_limiter.Allow(interval_ms))                     \
+      async_log::Write(async_log::Level::level, __FILE__, __LINE__, __VA_ARGS__);   \
+  } while (0)
@@ -4,15 +4,26 @@
 
 #include "browser.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <fmt/core.h>
 #include <optional>
 
-#include "data.h"
+#include "async_log.h"
+#include "event_tracer.h"
+#include "main_message_loop.h"
+#include "load_policy.h"
+#include "native_port.h"
 #include "renderer_delegate.h"
+#include "request_contexts.h"
+#include "request_blocker.h"
+#include "resource_monitor.h"
 #include "simple_handler.h"
 #include "include/wrapper/cef_helpers.h"
 #include "include/base/cef_callback.h"
+#include "include/base/cef_trace_event.h"
 #include "include/wrapper/cef_closure_task.h"
 #include <gdk/gdkkeysyms-compat.h>
 #include <gdk/gdkx.h>
@@ -29,6 +40,18 @@
 namespace
 
 {
+  // how long unused texture buffers are kept, popups often reopen quickly
+  constexpr int kOutletReleaseDelayMs = 5000;
+
+  // coarsest hidden snapshot, a 4K frame keeps about 500 KB of 33 MB
+  constexpr int kMaxSnapshotDivisor = 8;
+
+  // quiet period after the last size request before the page is laid out
+  constexpr int kResizeDebounceMs = 40;
+
+  // longest a pending size may wait while requests keep coming
+  constexpr int kMaxResizeLatencyMs = 150;
+
 
   int GetCefStateModifiers(guint state)
   {
@@ -878,6 +901,7 @@ namespace
 
   void SwapBufferFromBgraToRgba(void *_dest, const void *_src, int width, int height)
   {
+    TRACE_EVENT0(kTraceCategory, "SwapBufferFromBgraToRgba");
     int32_t *dest = (int32_t *)_dest;
     int32_t *src = (int32_t *)_src;
     int32_t rgba;
@@ -894,6 +918,84 @@ namespace
     }
   };
 
+  // Reads the [name, value] pairs of an applyBatch call, nothing is applied
+  // unless every command is valid.
+  bool ParseBatch(FlValue *args, std::vector<BatchCommand> &commands, std::string &error)
+  {
+    if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST)
+    {
+      error = "expected a list of commands";
+      return false;
+    }
+    const size_t count = fl_value_get_length(args);
+    commands.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      FlValue *entry = fl_value_get_list_value(args, i);
+      if (fl_value_get_type(entry) != FL_VALUE_TYPE_LIST || fl_value_get_length(entry) != 2 ||
+          fl_value_get_type(fl_value_get_list_value(entry, 0)) != FL_VALUE_TYPE_STRING)
+      {
+        error = fmt::format("command {} is not a [name, value] pair", i);
+        return false;
+      }
+      const std::string name = fl_value_get_string(fl_value_get_list_value(entry, 0));
+      FlValue *value = fl_value_get_list_value(entry, 1);
+      const FlValueType type = fl_value_get_type(value);
+      BatchCommand command;
+      if ((name == "setSize" || name == "setOffset") && type == FL_VALUE_TYPE_INT32_LIST &&
+          fl_value_get_length(value) == 2)
+      {
+        command.type = name == "setSize" ? BatchCommand::Type::Size : BatchCommand::Type::Offset;
+        command.x = fl_value_get_int32_list(value)[0];
+        command.y = fl_value_get_int32_list(value)[1];
+      }
+      else if ((name == "setCurrent" || name == "setHidden") && type == FL_VALUE_TYPE_BOOL)
+      {
+        command.type = name == "setCurrent" ? BatchCommand::Type::Current : BatchCommand::Type::Hidden;
+        command.flag = fl_value_get_bool(value);
+      }
+      else if (name == "setZoomLevel" && type == FL_VALUE_TYPE_FLOAT)
+      {
+        command.type = BatchCommand::Type::ZoomLevel;
+        command.level = fl_value_get_float(value);
+      }
+      else
+      {
+        error = fmt::format("command {} ({}) has an unknown name or value", i, name);
+        return false;
+      }
+      commands.push_back(command);
+    }
+    return true;
+  }
+
+  // Converts |width| x |height| BGRA pixels at |src_x|, |src_y| of |src| to
+  // RGBA at |dest_x|, |dest_y| of |dest|. Strides are in pixels.
+  void CopyRectFromBgraToRgba(uint8_t *dest, int dest_stride, int dest_x, int dest_y,
+                              const uint8_t *src, int src_stride, int src_x, int src_y,
+                              int width, int height)
+  {
+    for (int row = 0; row < height; row++)
+    {
+      const uint32_t *from = reinterpret_cast<const uint32_t *>(src) + (src_y + row) * src_stride + src_x;
+      uint32_t *to = reinterpret_cast<uint32_t *>(dest) + (dest_y + row) * dest_stride + dest_x;
+      for (int i = 0; i < width; i++)
+      {
+        const uint32_t bgra = from[i];
+        to[i] = (bgra & 0x00ff0000) >> 16 | (bgra & 0xff00ff00) | (bgra & 0x000000ff) << 16;
+      }
+    }
+  }
+
+  CefRect Intersect(const CefRect &a, const CefRect &b)
+  {
+    const int left = std::max(a.x, b.x);
+    const int top = std::max(a.y, b.y);
+    const int right = std::min(a.x + a.width, b.x + b.width);
+    const int bottom = std::min(a.y + a.height, b.y + b.height);
+    return right > left && bottom > top ? CefRect(left, top, right - left, bottom - top) : CefRect();
+  }
+
   const std::string &GetCursorName(const cef_cursor_type_t cursor)
   {
 
@@ -949,8 +1051,9 @@ namespace
                                           gpointer user_data)
   {
     struct BrowserStartParams *params = (struct BrowserStartParams *)user_data;
-    LOG(INFO) << "LISTEN CALLBACK received " << params->texture_id << " url " << params->url;
-    newBrowserInstance(params->texture_id, params->url, params->bind_func, params->token, params->access_token, params->parent);
+    ALOG(Info, "LISTEN CALLBACK received {}", params->texture_id);
+    newBrowserInstance(params->texture_id, params->url, params->bind_func, params->token, params->access_token, params->parent,
+                       params->context_key, params->persist_context);
     return NULL;
   }
 
@@ -980,18 +1083,32 @@ namespace
 
 }
 
-void newBrowserInstance(int64_t texture_id, const CefString &initialUrl, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget *parent)
+void respondOnMainThread(FlMethodCall *method_call, FlMethodResponse *response)
+{
+  MAIN_POST_CLOSURE(base::BindOnce(
+      [](FlMethodCall *method_call, FlMethodResponse *response)
+      {
+        fl_method_call_respond(method_call, response, nullptr);
+        g_object_unref(response);
+        g_object_unref(method_call);
+      },
+      method_call, response));
+}
+
+void newBrowserInstance(int64_t texture_id, const CefString &initialUrl, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget *parent,
+                        const std::string &context_key, bool persist_context)
 {
   if (!CefCurrentlyOn(TID_UI))
   {
-    CefPostTask(TID_UI, base::BindOnce(newBrowserInstance, texture_id, initialUrl, bind_func, token, access_token, parent));
+    CefPostTask(TID_UI, base::BindOnce(newBrowserInstance, texture_id, initialUrl, bind_func, token, access_token, parent,
+                                       context_key, persist_context));
     return;
   }
   else
   {
     GdkWindow *gdk = gtk_widget_get_window(parent);
     XID windowXID = GDK_WINDOW_XID(gdk);
-    LOG(INFO) << "browser XID is " << windowXID;
+    ALOG(Debug, "browser XID is {}", windowXID);
     CefWindowInfo window_info;
     window_info.SetAsWindowless(windowXID);
     CefBrowserSettings browser_settings;
@@ -1001,10 +1118,15 @@ void newBrowserInstance(int64_t texture_id, const CefString &initialUrl, const C
     extra->SetString("bind_func", bind_func);
     extra->SetString("token", token);
     extra->SetString("access_token", access_token);
-    CefBrowserHost::CreateBrowser(window_info, SimpleHandler::GetInstance(),
-                                  initialUrl, browser_settings,
-                                  extra, nullptr);
-    LOG(INFO) << "Sent request to create browser for texture " << texture_id << " with initial url " << initialUrl;
+    if (!CefBrowserHost::CreateBrowser(window_info, SimpleHandler::GetInstance(),
+                                       initialUrl, browser_settings,
+                                       extra, request_contexts::Acquire(context_key, persist_context)))
+    {
+      request_contexts::Cancel(context_key);
+      ALOG(Warning, "Failed to create browser for texture {}", texture_id);
+      return;
+    }
+    ALOG(Info, "Sent request to create browser for texture {}", texture_id);
   }
 }
 
@@ -1018,12 +1140,14 @@ static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
 
   const gchar *method = fl_method_call_get_name(method_call);
   FlValue *args = fl_method_call_get_args(method_call);
+  TRACE_EVENT_COPY_BEGIN0(kTraceCategory, method);
+  EVENT_TRACE_SCOPE(MethodCall);
 
   if (strcmp(method, "petTexture") == 0)
   {
 
-    LOG(INFO) << "received request for pet texture";
-    g_autoptr(FlValue) result = fl_value_new_int(get_video_outlet_private(bridge->texture_bridge_pet)->texture_id);
+    ALOG(Debug, "received request for pet texture");
+    g_autoptr(FlValue) result = fl_value_new_int(bridge->pet_texture_id);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
   else if (strcmp(method, "loadUrl") == 0)
@@ -1073,8 +1197,12 @@ static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
   else if (strcmp(method, "getTextSelection") == 0)
   {
     bridge->clearAllCookies();
-    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(client::renderer::kTextSelectionReport);
-    bridge->browser_->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+    CefRefPtr<CefBrowser> browser = bridge->currentBrowser();
+    if (browser)
+    {
+      CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(client::renderer::kTextSelectionReport);
+      browser->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+    }
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
   }
   else if (strcmp(method, "executeJavaScript") == 0)
@@ -1098,7 +1226,7 @@ static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
   else if (strcmp(method, "setHidden") == 0)
   {
     auto hide = fl_value_get_bool(args);
-    bridge->browser_->GetHost()->WasHidden(hide);
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setHidden, CefRefPtr<BrowserBridge>(bridge), static_cast<bool>(hide)));
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
   }
   else if (strcmp(method, "setCurrent") == 0)
@@ -1142,12 +1270,158 @@ static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
     bridge->setCursorPos(x, y);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
   }
+  else if (strcmp(method, "getResourceUsage") == 0)
+  {
+    g_autoptr(FlValue) result = bridge->getResourceUsage();
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  else if (strcmp(method, "setBlockList") == 0)
+  {
+    CefRefPtr<CefBrowser> browser = bridge->currentBrowser();
+    if (!browser)
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("browserNotReady", "the browser is not created yet", nullptr));
+    }
+    else
+    {
+      // large lists take a while to compile, keep it off the platform thread
+      const int browser_id = browser->GetIdentifier();
+      std::string rules = fl_value_get_string(args);
+      g_object_ref(method_call);
+      CefPostTask(TID_FILE_USER_BLOCKING, base::BindOnce(
+                                              [](FlMethodCall *method_call, int browser_id, std::string rules)
+                                              {
+                                                size_t count = 0;
+                                                auto list = rules.empty() ? nullptr : request_blocker::FilterList::Compile(rules, count);
+                                                request_blocker::Registry::GetInstance()->SetFilterList(browser_id, std::move(list), count);
+                                                g_autoptr(FlValue) result = fl_value_new_int(count);
+                                                respondOnMainThread(method_call, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+                                              },
+                                              method_call, browser_id, std::move(rules)));
+      TRACE_EVENT_COPY_END0(kTraceCategory, method);
+      return;
+    }
+  }
+  else if (strcmp(method, "setLoadPolicy") == 0)
+  {
+    CefRefPtr<CefBrowser> browser = bridge->currentBrowser();
+    if (!browser)
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("browserNotReady", "the browser is not created yet", nullptr));
+    }
+    else
+    {
+      auto action = [args](const char *key)
+      {
+        FlValue *value = fl_value_lookup_string(args, key);
+        return value ? static_cast<load_policy::Action>(fl_value_get_int(value)) : load_policy::Action::Allow;
+      };
+      load_policy::Policy policy;
+      policy.images = action("images");
+      policy.fonts = action("fonts");
+      policy.media = action("media");
+      policy.third_party_scripts = action("thirdPartyScripts");
+      FlValue *max_image_bytes = fl_value_lookup_string(args, "maxImageBytes");
+      policy.max_image_bytes = max_image_bytes ? fl_value_get_int(max_image_bytes) : 0;
+      FlValue *defer_ms = fl_value_lookup_string(args, "deferMs");
+      if (defer_ms)
+      {
+        policy.defer_ms = fl_value_get_int(defer_ms);
+      }
+      load_policy::Registry::GetInstance()->SetPolicy(browser->GetIdentifier(), policy);
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+    }
+  }
+  else if (strcmp(method, "prerender") == 0)
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::prerender, CefRefPtr<BrowserBridge>(bridge), std::string(fl_value_get_string(args))));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "applyBatch") == 0)
+  {
+    std::vector<BatchCommand> commands;
+    std::string error;
+    if (!bridge->currentBrowser())
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("browserNotReady", "the browser is not created yet", nullptr));
+    }
+    else if (!ParseBatch(args, commands, error))
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("invalidCommand", error.c_str(), nullptr));
+    }
+    else
+    {
+      // answered once every command took effect
+      g_object_ref(method_call);
+      CefPostTask(TID_UI, base::BindOnce(
+                              [](CefRefPtr<BrowserBridge> bridge, std::vector<BatchCommand> commands, FlMethodCall *method_call)
+                              {
+                                bridge->applyBatch(commands);
+                                g_autoptr(FlValue) result = fl_value_new_int(commands.size());
+                                respondOnMainThread(method_call, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+                              },
+                              CefRefPtr<BrowserBridge>(bridge), std::move(commands), method_call));
+      TRACE_EVENT_COPY_END0(kTraceCategory, method);
+      return;
+    }
+  }
+  else if (strcmp(method, "setHiddenSnapshot") == 0)
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setHiddenSnapshot, CefRefPtr<BrowserBridge>(bridge),
+                                       static_cast<int>(fl_value_get_int(args))));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "setRenderScale") == 0)
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setRenderScale, CefRefPtr<BrowserBridge>(bridge), fl_value_get_float(args)));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "setDevicePixelRatio") == 0)
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setDevicePixelRatio, CefRefPtr<BrowserBridge>(bridge), fl_value_get_float(args)));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "sendEventProbes") == 0)
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::sendEventProbes, CefRefPtr<BrowserBridge>(bridge), static_cast<int>(fl_value_get_int(args))));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "setNetworkTimingEnabled") == 0)
+  {
+    CefRefPtr<CefBrowser> browser = bridge->currentBrowser();
+    if (!browser)
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("browserNotReady", "the browser is not created yet", nullptr));
+    }
+    else
+    {
+      network_timing::Registry::GetInstance()->SetEnabled(browser->GetIdentifier(), fl_value_get_bool(args));
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+    }
+  }
+  else if (strcmp(method, "getBlockingStats") == 0)
+  {
+    CefRefPtr<CefBrowser> browser = bridge->currentBrowser();
+    const auto stats = request_blocker::Registry::GetInstance()->GetStats(browser ? browser->GetIdentifier() : -1);
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "blockedRequests", fl_value_new_int(stats.blocked_requests));
+    fl_value_set_string_take(result, "estimatedBytesSaved", fl_value_new_int(stats.estimated_bytes_saved));
+    fl_value_set_string_take(result, "rules", fl_value_new_int(stats.rules));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  else if (strcmp(method, "setPerformanceMetricsInterval") == 0)
+  {
+    auto interval = fl_value_get_int(args);
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setPerformanceMetricsInterval, CefRefPtr<BrowserBridge>(bridge), static_cast<int>(interval)));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
   else
   {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
 
   fl_method_call_respond(method_call, response, nullptr);
+  TRACE_EVENT_COPY_END0(kTraceCategory, method);
 }
 
 BrowserBridge::BrowserBridge(
@@ -1156,22 +1430,14 @@ BrowserBridge::BrowserBridge(
     : texture_registrar_(texture_registrar)
 {
   texture_bridge = video_outlet_new();
-  texture_bridge_pet = video_outlet_new();
 
   fl_texture_registrar_register_texture(texture_registrar,
                                         FL_TEXTURE(texture_bridge));
-  fl_texture_registrar_register_texture(texture_registrar,
-                                        FL_TEXTURE(texture_bridge_pet));
   auto video_outlet_private_main =
       get_video_outlet_private(texture_bridge);
   video_outlet_private_main->texture_id =
       reinterpret_cast<int64_t>(FL_TEXTURE(texture_bridge));
 
-  auto video_outlet_private_pet =
-      get_video_outlet_private(texture_bridge_pet);
-  video_outlet_private_pet->texture_id =
-      reinterpret_cast<int64_t>(FL_TEXTURE(texture_bridge_pet));
-
   const auto method_channel_name =
       fmt::format("webview_cef/{}", video_outlet_private_main->texture_id);
 
@@ -1188,7 +1454,7 @@ BrowserBridge::BrowserBridge(
   const auto event_channel_name =
       fmt::format("webview_cef/{}/events", video_outlet_private_main->texture_id);
 
-  LOG(INFO) << "Creating event_channel " << event_channel_name;
+  ALOG(Debug, "Creating event_channel {}", event_channel_name);
 
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   event_channel_ = fl_event_channel_new(messenger, event_channel_name.c_str(),
@@ -1206,12 +1472,18 @@ BrowserBridge::BrowserBridge(
 
 void BrowserBridge::send_buffer(bool pet, const void *buffer, int32_t width, int32_t height)
 {
+  TRACE_EVENT2(kTraceCategory, "BrowserBridge::send_buffer", "width", width, "height", height);
+  EVENT_TRACE_SCOPE1(SendBuffer, pet);
   VideoOutletPrivate *video_outlet_private;
   VideoOutlet *video_outlet;
   if (pet)
   {
+    if (!texture_bridge_pet)
+    {
+      return;
+    }
     video_outlet_private = get_video_outlet_private(texture_bridge_pet);
-    video_outlet = texture_bridge;
+    video_outlet = texture_bridge_pet;
   }
   else
   {
@@ -1225,26 +1497,281 @@ void BrowserBridge::send_buffer(bool pet, const void *buffer, int32_t width, int
   SwapBufferFromBgraToRgba(video_outlet_private->buffer.get(), buffer, width, height);
   video_outlet_private->video_width = width;
   video_outlet_private->video_height = height;
+  if (!pet)
+  {
+    // a full frame, any snapshot is gone now
+    snapshot_bytes = 0;
+  }
+  paint_count++;
+  paint_bytes += size;
   fl_texture_registrar_mark_texture_frame_available(
       texture_registrar_, FL_TEXTURE(video_outlet));
 }
 
+void BrowserBridge::setPopupCompositing(bool enabled)
+{
+  composite_popup_ = enabled;
+}
+
+void BrowserBridge::compositeFrame(CefRenderHandler::PaintElementType type,
+                                   const CefRenderHandler::RectList &dirty_rects,
+                                   const void *buffer, int width, int height)
+{
+  CEF_REQUIRE_UI_THREAD();
+  TRACE_EVENT2(kTraceCategory, "BrowserBridge::compositeFrame", "type", type, "dirty_rects", dirty_rects.size());
+  EVENT_TRACE_SCOPE1(SendBuffer, type == PET_POPUP);
+  const auto *pixels = static_cast<const uint8_t *>(buffer);
+  const size_t size = static_cast<size_t>(width) * height * 4;
+  if (type == PET_POPUP)
+  {
+    popup_pixels_.assign(pixels, pixels + size);
+    popup_pixels_size_ = CefSize(width, height);
+  }
+  else
+  {
+    view_pixels_.resize(size);
+    // only the dirty rects changed, unless the frame size did
+    CefRenderHandler::RectList rects = dirty_rects;
+    if (view_pixels_size_ != CefSize(width, height))
+    {
+      view_pixels_size_ = CefSize(width, height);
+      rects = {CefRect(0, 0, width, height)};
+    }
+    for (const auto &rect : rects)
+    {
+      const CefRect clipped = Intersect(rect, CefRect(0, 0, width, height));
+      for (int row = clipped.y; row < clipped.y + clipped.height; row++)
+      {
+        const size_t offset = (static_cast<size_t>(row) * width + clipped.x) * 4;
+        memcpy(view_pixels_.data() + offset, pixels + offset, clipped.width * 4);
+      }
+    }
+  }
+  if (view_pixels_.empty())
+  {
+    return;
+  }
+
+  VideoOutletPrivate *outlet = get_video_outlet_private(texture_bridge);
+  {
+    const std::lock_guard<std::mutex> lock(outlet->mutex);
+    const int view_width = view_pixels_size_.width;
+    const int view_height = view_pixels_size_.height;
+    bool redraw_popup = type == PET_POPUP;
+    if (!outlet->buffer || outlet->video_width != view_width || outlet->video_height != view_height)
+    {
+      outlet->buffer.reset(new uint8_t[view_pixels_.size()]);
+      outlet->video_width = view_width;
+      outlet->video_height = view_height;
+      // this replaces the snapshot, if any
+      snapshot_bytes = 0;
+      restoreViewRect(outlet, CefRect(0, 0, view_width, view_height));
+      redraw_popup = true;
+    }
+    else if (type == PET_VIEW)
+    {
+      for (const auto &rect : dirty_rects)
+      {
+        restoreViewRect(outlet, rect);
+        redraw_popup |= !Intersect(rect, popup_rect_).IsEmpty();
+      }
+    }
+    if (popup_visible_ && redraw_popup)
+    {
+      drawPopup(outlet);
+    }
+  }
+  paint_count++;
+  paint_bytes += size;
+  fl_texture_registrar_mark_texture_frame_available(texture_registrar_, FL_TEXTURE(texture_bridge));
+}
+
+void BrowserBridge::restoreViewRect(VideoOutletPrivate *outlet, const CefRect &rect)
+{
+  const int stride = view_pixels_size_.width;
+  const CefRect clipped = Intersect(rect, CefRect(0, 0, view_pixels_size_.width, view_pixels_size_.height));
+  CopyRectFromBgraToRgba(outlet->buffer.get(), stride, clipped.x, clipped.y,
+                         view_pixels_.data(), stride, clipped.x, clipped.y,
+                         clipped.width, clipped.height);
+}
+
+void BrowserBridge::drawPopup(VideoOutletPrivate *outlet)
+{
+  if (popup_pixels_.empty())
+  {
+    return;
+  }
+  // the popup frame may be a pixel off the scaled rect, draw their overlap
+  const CefRect target(popup_rect_.x, popup_rect_.y,
+                       std::min(popup_rect_.width, popup_pixels_size_.width),
+                       std::min(popup_rect_.height, popup_pixels_size_.height));
+  const CefRect clipped = Intersect(target, CefRect(0, 0, view_pixels_size_.width, view_pixels_size_.height));
+  CopyRectFromBgraToRgba(outlet->buffer.get(), view_pixels_size_.width, clipped.x, clipped.y,
+                         popup_pixels_.data(), popup_pixels_size_.width,
+                         clipped.x - popup_rect_.x, clipped.y - popup_rect_.y,
+                         clipped.width, clipped.height);
+}
+
 void BrowserBridge::setBrowser(CefRefPtr<CefBrowser> &browser)
 {
-  browser_ = browser;
+  bool sized;
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    browser_ = browser;
+    sized = !view_size_.IsEmpty();
+    hidden_until_sized_ = !sized;
+  }
+  if (sized)
+  {
+    // GetViewRect answered a placeholder until the browser was mapped
+    browser->GetHost()->WasResized();
+  }
+  applyVisibility();
+}
+
+void BrowserBridge::setInitialSize(int width, int height, double device_scale)
+{
+  std::lock_guard<std::mutex> lock(geometry_mutex_);
+  if (width > 0 && height > 0)
+  {
+    view_size_ = requested_size_ = CefSize(width, height);
+  }
+  if (device_scale > 0)
+  {
+    device_scale_ = device_scale;
+  }
+}
+
+bool BrowserBridge::acceptViewFrame(int width, int height)
+{
+  CefSize size;
+  double scale;
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    size = view_size_;
+    scale = device_scale_ * render_scale_;
+  }
+  // chromium rounds the scaled size, allow a pixel either way
+  const double expected_width = size.width * scale;
+  const double expected_height = size.height * scale;
+  if (std::abs(width - expected_width) <= 1 && std::abs(height - expected_height) <= 1)
+  {
+    return true;
+  }
+  discarded_frames++;
+  return false;
+}
+
+double BrowserBridge::paintScale()
+{
+  std::lock_guard<std::mutex> lock(geometry_mutex_);
+  return device_scale_ * render_scale_;
+}
+
+void BrowserBridge::setRenderScale(double scale)
+{
+  CEF_REQUIRE_UI_THREAD();
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    scale = std::clamp(scale, 0.25, 1.0);
+    if (scale == render_scale_)
+    {
+      return;
+    }
+    render_scale_ = scale;
+  }
+  if (browser_ && !closing)
+  {
+    browser_->GetHost()->NotifyScreenInfoChanged();
+    browser_->GetHost()->WasResized();
+  }
+}
+
+void BrowserBridge::setDevicePixelRatio(double ratio)
+{
+  CEF_REQUIRE_UI_THREAD();
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    if (ratio <= 0 || ratio == device_scale_)
+    {
+      return;
+    }
+    device_scale_ = ratio;
+  }
+  // GetScreenInfo reports the new scale, the view repaints at it
+  if (browser_ && !closing)
+  {
+    browser_->GetHost()->NotifyScreenInfoChanged();
+    browser_->GetHost()->WasResized();
+  }
+}
+
+void BrowserBridge::setHiddenSnapshot(int divisor)
+{
+  CEF_REQUIRE_UI_THREAD();
+  hidden_snapshot_divisor_ = divisor <= 1 ? 0 : std::min(divisor, kMaxSnapshotDivisor);
+}
+
+void BrowserBridge::setRequestContext(const std::string &key, bool persistent)
+{
+  params.context_key = key;
+  params.persist_context = persistent;
+}
+
+void BrowserBridge::setEventPort(int64_t port)
+{
+  event_port_ = port;
+}
+
+gboolean BrowserBridge::sendEvent(FlValue *message, GError **error)
+{
+  if (event_port_ != 0)
+  {
+    return native_port::Post(event_port_, message, error);
+  }
+  return fl_event_channel_send(event_channel_, message, NULL, error);
+}
+
+void BrowserBridge::sendEventProbes(int count)
+{
+  CEF_REQUIRE_UI_THREAD();
+  for (int i = 0; i < count; i++)
+  {
+    const int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+    g_autoptr(FlValue) message = fl_value_new_map();
+    fl_value_set_string_take(message, kEventType, fl_value_new_string("eventProbe"));
+    fl_value_set_string_take(message, kEventValue, fl_value_new_int(now_us));
+    g_autoptr(GError) error = NULL;
+    if (!sendEvent(message, &error))
+    {
+      g_warning("Failed to send eventProbe event: %s", error->message);
+      return;
+    }
+  }
 }
 
 void BrowserBridge::clearAllCookies()
 {
   CefRefPtr<CefDeleteCookiesCallback> callback =
       new WebviewCookieClearCompletionCallBack(WebviewEvent::CookiesCleared, this);
-  CefCookieManager::GetGlobalManager(nullptr)->DeleteCookies("", "", callback);
+  // only the cookies of this browser's context, other sessions keep theirs
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  CefRefPtr<CefCookieManager> manager = browser
+                                            ? browser->GetHost()->GetRequestContext()->GetCookieManager(nullptr)
+                                            : CefCookieManager::GetGlobalManager(nullptr);
+  manager->DeleteCookies("", "", callback);
 }
 
 BrowserBridge::~BrowserBridge()
 {
   fl_texture_registrar_unregister_texture(texture_registrar_, FL_TEXTURE(texture_bridge));
-  fl_texture_registrar_unregister_texture(texture_registrar_, FL_TEXTURE(texture_bridge_pet));
+  if (texture_bridge_pet)
+  {
+    fl_texture_registrar_unregister_texture(texture_registrar_, FL_TEXTURE(texture_bridge_pet));
+    g_object_unref(texture_bridge_pet);
+  }
   fl_method_channel_set_method_call_handler(method_channel_, nullptr, nullptr, nullptr);
 }
 
@@ -1258,29 +1785,242 @@ void BrowserBridge::OnLoadingStateChange(
   fl_value_set_string_take(message, kEventValue,
                            fl_value_new_int(isLoading ? static_cast<int>(WebviewLoadingState::InProcess) : static_cast<int>(WebviewLoadingState::NavigationCompleted)));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send loadingState event: %s", error->message);
   }
 }
 
+void BrowserBridge::OnCacheStats(const cache_metrics::PageStats &stats)
+{
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "requests", fl_value_new_int(stats.requests));
+  fl_value_set_string_take(value, "cachedRequests", fl_value_new_int(stats.cached_requests));
+  fl_value_set_string_take(value, "networkBytes", fl_value_new_int(stats.network_bytes));
+  g_autoptr(FlValue) message = fl_value_new_map();
+  fl_value_set_string_take(message, kEventType, fl_value_new_string("cacheStats"));
+  fl_value_set_string(message, kEventValue, value);
+  g_autoptr(GError) error = NULL;
+  if (!sendEvent(message, &error))
+  {
+    g_warning("Failed to send cacheStats event: %s", error->message);
+  }
+}
+
+void BrowserBridge::OnNetworkTiming(const network_timing::Page &page)
+{
+  // one column per field, times in microseconds since the page's first
+  // request
+  const size_t count = page.requests.size();
+  auto micros = [origin = page.origin](std::chrono::steady_clock::time_point time)
+  {
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time - origin).count());
+  };
+  std::vector<int64_t> start(count), response_start(count), end(count), bytes(count);
+  std::vector<int32_t> status(count);
+  std::vector<uint8_t> type(count), result(count);
+  g_autoptr(FlValue) urls = fl_value_new_list();
+  for (size_t i = 0; i < count; i++)
+  {
+    const auto &request = page.requests[i];
+    fl_value_append_take(urls, fl_value_new_string(request.url.c_str()));
+    start[i] = micros(request.start);
+    response_start[i] = request.response_start ? micros(*request.response_start) : -1;
+    end[i] = micros(request.end);
+    bytes[i] = request.received_bytes;
+    status[i] = request.http_status;
+    type[i] = static_cast<uint8_t>(request.type);
+    result[i] = static_cast<uint8_t>(request.result);
+  }
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string(value, "url", urls);
+  fl_value_set_string_take(value, "type", fl_value_new_uint8_list(type.data(), count));
+  fl_value_set_string_take(value, "start", fl_value_new_int64_list(start.data(), count));
+  fl_value_set_string_take(value, "responseStart", fl_value_new_int64_list(response_start.data(), count));
+  fl_value_set_string_take(value, "end", fl_value_new_int64_list(end.data(), count));
+  fl_value_set_string_take(value, "bytes", fl_value_new_int64_list(bytes.data(), count));
+  fl_value_set_string_take(value, "status", fl_value_new_int32_list(status.data(), count));
+  fl_value_set_string_take(value, "result", fl_value_new_uint8_list(result.data(), count));
+  fl_value_set_string_take(value, "dropped", fl_value_new_int(page.dropped));
+  fl_value_set_string_take(value, "page", fl_value_new_int(page.id));
+  g_autoptr(FlValue) message = fl_value_new_map();
+  fl_value_set_string_take(message, kEventType, fl_value_new_string("networkTiming"));
+  fl_value_set_string(message, kEventValue, value);
+  g_autoptr(GError) error = NULL;
+  if (!sendEvent(message, &error))
+  {
+    g_warning("Failed to send networkTiming event: %s", error->message);
+  }
+}
+
 void BrowserBridge::onPopupShow(bool show)
+{
+  if (composite_popup_)
+  {
+    popup_visible_ = show;
+    if (!show && !view_pixels_.empty())
+    {
+      VideoOutletPrivate *outlet = get_video_outlet_private(texture_bridge);
+      {
+        const std::lock_guard<std::mutex> lock(outlet->mutex);
+        if (outlet->buffer)
+        {
+          restoreViewRect(outlet, popup_rect_);
+        }
+      }
+      popup_pixels_.clear();
+      popup_rect_ = CefRect();
+      fl_texture_registrar_mark_texture_frame_available(texture_registrar_, FL_TEXTURE(texture_bridge));
+    }
+    return;
+  }
+  popup_visible_ = show;
+  const int generation = ++popup_outlet_generation_;
+  if (!show)
+  {
+    CefPostDelayedTask(TID_UI, base::BindOnce(&BrowserBridge::releasePopupOutlet, CefRefPtr<BrowserBridge>(this), generation),
+                       kOutletReleaseDelayMs);
+  }
+  else if (!texture_bridge_pet)
+  {
+    texture_bridge_pet = video_outlet_new();
+    auto outlet_private = get_video_outlet_private(texture_bridge_pet);
+    outlet_private->texture_id = reinterpret_cast<int64_t>(FL_TEXTURE(texture_bridge_pet));
+    pet_texture_id = outlet_private->texture_id;
+    // Dart is told about the popup once its texture can be shown
+    MAIN_POST_CLOSURE(base::BindOnce(&BrowserBridge::registerPopupOutlet, CefRefPtr<BrowserBridge>(this),
+                                     texture_bridge_pet));
+    return;
+  }
+  sendPopupShow(show);
+}
+
+void BrowserBridge::sendPopupShow(bool show)
 {
   g_autoptr(FlValue) message = fl_value_new_map();
   fl_value_set_string_take(message, kEventType, fl_value_new_string("popupShow"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_bool(show));
+  fl_value_set_string_take(message, "texture", fl_value_new_int(pet_texture_id));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onPopupShow event: %s", error->message);
   }
 }
 
+void BrowserBridge::registerPopupOutlet(VideoOutlet *outlet)
+{
+  fl_texture_registrar_register_texture(texture_registrar_, FL_TEXTURE(outlet));
+  // frames painted before the registration were not announced
+  fl_texture_registrar_mark_texture_frame_available(texture_registrar_, FL_TEXTURE(outlet));
+  sendPopupShow(true);
+}
+
+void BrowserBridge::releasePopupOutlet(int generation)
+{
+  CEF_REQUIRE_UI_THREAD();
+  if (generation != popup_outlet_generation_ || popup_visible_ || !texture_bridge_pet)
+  {
+    return;
+  }
+  VideoOutlet *outlet = texture_bridge_pet;
+  texture_bridge_pet = nullptr;
+  pet_texture_id = 0;
+  MAIN_POST_CLOSURE(base::BindOnce(
+      [](FlTextureRegistrar *texture_registrar, VideoOutlet *outlet)
+      {
+        fl_texture_registrar_unregister_texture(texture_registrar, FL_TEXTURE(outlet));
+        g_object_unref(outlet);
+      },
+      texture_registrar_, outlet));
+}
+
+void BrowserBridge::setHidden(bool hidden)
+{
+  CEF_REQUIRE_UI_THREAD();
+  hidden_ = hidden;
+  const int generation = ++view_outlet_generation_;
+  applyVisibility();
+  if (!browser_ || closing)
+  {
+    return;
+  }
+  if (hidden)
+  {
+    CefPostDelayedTask(TID_UI, base::BindOnce(&BrowserBridge::releaseViewBuffers, CefRefPtr<BrowserBridge>(this), generation),
+                       kOutletReleaseDelayMs);
+  }
+  else if (view_buffers_released_)
+  {
+    // the snapshot, if any, stays up until this repaint replaces it
+    view_buffers_released_ = false;
+    browser_->GetHost()->Invalidate(PET_VIEW);
+  }
+}
+
+void BrowserBridge::applyVisibility()
+{
+  CEF_REQUIRE_UI_THREAD();
+  bool hidden;
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    hidden = hidden_ || hidden_until_sized_;
+  }
+  if (browser_ && !closing)
+  {
+    browser_->GetHost()->WasHidden(hidden);
+  }
+}
+
+void BrowserBridge::releaseViewBuffers(int generation)
+{
+  CEF_REQUIRE_UI_THREAD();
+  if (generation != view_outlet_generation_ || !hidden_)
+  {
+    return;
+  }
+  size_t freed = view_pixels_.capacity();
+  size_t snapshot = 0;
+  if (hidden_snapshot_divisor_)
+  {
+    freed += video_outlet_shrink_buffers(texture_bridge, hidden_snapshot_divisor_, &snapshot);
+  }
+  else
+  {
+    freed += video_outlet_release_buffers(texture_bridge);
+  }
+  std::vector<uint8_t>().swap(view_pixels_);
+  buffer_releases++;
+  released_buffer_bytes += freed;
+  snapshot_bytes = snapshot;
+  view_pixels_size_ = CefSize();
+  view_buffers_released_ = true;
+  // the next copy_pixels frees the copy Flutter uploaded from
+  fl_texture_registrar_mark_texture_frame_available(texture_registrar_, FL_TEXTURE(texture_bridge));
+}
+
 void BrowserBridge::OnPopupSize(int x,
                                 int y,
                                 int popupWidth,
                                 int popupHeight)
 {
+  if (composite_popup_)
+  {
+    // moved or resized, the popup is drawn again with its next frame
+    if (popup_visible_ && !view_pixels_.empty())
+    {
+      VideoOutletPrivate *outlet = get_video_outlet_private(texture_bridge);
+      const std::lock_guard<std::mutex> lock(outlet->mutex);
+      if (outlet->buffer)
+      {
+        restoreViewRect(outlet, popup_rect_);
+      }
+    }
+    const double scale = paintScale();
+    popup_rect_ = CefRect(std::lround(x * scale), std::lround(y * scale),
+                          std::lround(popupWidth * scale), std::lround(popupHeight * scale));
+    return;
+  }
   g_autoptr(FlValue) message = fl_value_new_map();
   fl_value_set_string_take(message, kEventType, fl_value_new_string("popupSize"));
   fl_value_set_string_take(message, "x", fl_value_new_int(x));
@@ -1288,7 +2028,7 @@ void BrowserBridge::OnPopupSize(int x,
   fl_value_set_string_take(message, "width", fl_value_new_int(popupWidth));
   fl_value_set_string_take(message, "hieght", fl_value_new_int(popupHeight));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onPopupSize event: %s", error->message);
   }
@@ -1300,7 +2040,7 @@ void BrowserBridge::OnWebMessage(const CefString &web_message)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("webMessage"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_string(web_message.ToString().c_str()));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onWebMessage event: %s", error->message);
   }
@@ -1316,7 +2056,11 @@ void BrowserBridge::setToken(std::string token)
   CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(client::renderer::kTokenUpdate);
   CefRefPtr<CefListValue> args = message->GetArgumentList();
   args->SetString(0, token);
-  browser_->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+  }
 }
 
 void BrowserBridge::setAccessToken(std::string token)
@@ -1324,7 +2068,11 @@ void BrowserBridge::setAccessToken(std::string token)
   CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(client::renderer::kAccessTokenUpdate);
   CefRefPtr<CefListValue> args = message->GetArgumentList();
   args->SetString(0, token);
-  browser_->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
+  }
 }
 
 void BrowserBridge::OnShutdown()
@@ -1338,7 +2086,7 @@ void BrowserBridge::OnTitleChanged(const CefString &title)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("titleChanged"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_string(title.ToString().c_str()));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onTitleChanged event: %s", error->message);
   }
@@ -1351,7 +2099,7 @@ void BrowserBridge::textSelectionReport(const CefString &text_selection)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("textSelectionReport"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_string(text_selection.ToString().c_str()));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send textSelectionReport event: %s", error->message);
   }
@@ -1365,7 +2113,7 @@ void BrowserBridge::onCursorChanged(const cef_cursor_type_t cursor)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("cursorChanged"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_string(name.c_str()));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onCursorChanged event: %s", error->message);
   }
@@ -1377,7 +2125,7 @@ void BrowserBridge::OnUrlChanged(const CefString &url)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("urlChanged"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_string(url.ToString().c_str()));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onUrlChanged event: %s", error->message);
   }
@@ -1390,7 +2138,7 @@ void BrowserBridge::browserEvent(WebviewEvent event)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("browserEvent"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_int(static_cast<int>(event)));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send onUrlChanged event: %s", error->message);
   }
@@ -1404,7 +2152,7 @@ void BrowserBridge::OnWebviewStateChange(WebviewState state)
   fl_value_set_string_take(message, kEventType, fl_value_new_string("browserState"));
   fl_value_set_string_take(message, kEventValue, fl_value_new_int(static_cast<int>(state)));
   g_autoptr(GError) error = NULL;
-  if (!fl_event_channel_send(event_channel_, message, NULL, &error))
+  if (!sendEvent(message, &error))
   {
     g_warning("Failed to send event: %s", error->message);
   }
@@ -1412,35 +2160,246 @@ void BrowserBridge::OnWebviewStateChange(WebviewState state)
 
 void BrowserBridge::loadUrl(const CefString &url)
 {
+  if (!CefCurrentlyOn(TID_UI))
+  {
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::loadUrl, CefRefPtr<BrowserBridge>(this), url));
+    return;
+  }
+  if (!browser_)
+  {
+    return;
+  }
+  inline_document_ = nullptr;
+  if (swapInPrerendered(url))
+  {
+    return;
+  }
   browser_->GetMainFrame()->LoadURL(url);
 }
 
+void BrowserBridge::prerender(const std::string &url)
+{
+  CEF_REQUIRE_UI_THREAD();
+  discardPrerender();
+  if (url.empty() || !browser_ || closing)
+  {
+    return;
+  }
+  CefWindowInfo window_info;
+  window_info.SetAsWindowless(GDK_WINDOW_XID(gtk_widget_get_window(params.parent)));
+  CefBrowserSettings browser_settings;
+  // nothing is shown, a frame per second keeps the compositor alive
+  browser_settings.windowless_frame_rate = 1;
+  CefRefPtr<CefDictionaryValue> extra = CefDictionaryValue::Create();
+  extra->SetString("texture_id", std::to_string(texture_id()));
+  extra->SetString("bind_func", params.bind_func);
+  extra->SetString("token", params.token);
+  extra->SetString("access_token", params.access_token);
+  // start blank so the policies are in place before the first request
+  prerender_ = CefBrowserHost::CreateBrowserSync(window_info, SimpleHandler::GetInstance(), "about:blank",
+                                                 browser_settings, extra, browser_->GetHost()->GetRequestContext());
+  if (!prerender_)
+  {
+    ALOG(Warning, "Failed to create prerender browser for texture {}", texture_id());
+    return;
+  }
+  SimpleHandler::GetInstance()->addPrerendered(prerender_, texture_id());
+  request_blocker::Registry::GetInstance()->Copy(browser_->GetIdentifier(), prerender_->GetIdentifier());
+  load_policy::Registry::GetInstance()->Copy(browser_->GetIdentifier(), prerender_->GetIdentifier());
+  prerender_url_ = url;
+  prerender_->GetMainFrame()->LoadURL(url);
+  ALOG(Debug, "Prerendering in browser {} for texture {}", prerender_->GetIdentifier(), texture_id());
+}
+
+bool BrowserBridge::swapInPrerendered(const CefString &url)
+{
+  if (!prerender_ || (url != prerender_url_ && url != prerender_->GetMainFrame()->GetURL()))
+  {
+    return false;
+  }
+  CefRefPtr<CefBrowser> companion = prerender_;
+  prerender_ = nullptr;
+  prerender_url_.clear();
+  auto prerendered = SimpleHandler::GetInstance()->adoptPrerendered(browser_->GetIdentifier(), companion);
+  if (!prerendered)
+  {
+    // the companion closed on its own, e.g. after a renderer crash
+    return false;
+  }
+
+  CefRefPtr<CefBrowser> previous = browser_;
+  if (devtools_)
+  {
+    devtools_->Detach();
+    devtools_ = nullptr;
+  }
+  network_timing::Registry::GetInstance()->Copy(previous->GetIdentifier(), companion->GetIdentifier());
+  if (prerendered->renderer_pid > 0)
+  {
+    ResourceMonitor::GetInstance()->Register(texture_id(), prerendered->renderer_pid);
+  }
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    browser_ = companion;
+  }
+
+  CefRefPtr<CefBrowserHost> host = companion->GetHost();
+  host->SetWindowlessFrameRate(60);
+  host->WasResized();
+  applyVisibility();
+  host->Invalidate(PET_VIEW);
+  if (isCurrent)
+  {
+    host->SetFocus(true);
+  }
+  // the previous browser is no longer routed to this bridge, its close goes unnoticed
+  previous->GetHost()->CloseBrowser(true);
+
+  if (performance_interval_ms_ > 0)
+  {
+    // enable the Performance domain on the new browser
+    const int interval_ms = performance_interval_ms_;
+    performance_interval_ms_ = 0;
+    setPerformanceMetricsInterval(interval_ms);
+  }
+  OnUrlChanged(companion->GetMainFrame()->GetURL());
+  if (!prerendered->title.empty())
+  {
+    OnTitleChanged(prerendered->title);
+  }
+  OnLoadingStateChange(companion->IsLoading(), companion->CanGoBack(), companion->CanGoForward());
+  ALOG(Info, "Swapped in prerendered browser {} for texture {}", companion->GetIdentifier(), texture_id());
+  return true;
+}
+
+void BrowserBridge::discardPrerender()
+{
+  if (prerender_)
+  {
+    prerender_->GetHost()->CloseBrowser(true);
+    prerender_ = nullptr;
+  }
+  prerender_url_.clear();
+}
+
 void BrowserBridge::loadHTML(std::string text)
 {
-  browser_->GetMainFrame()->LoadURL(GetDataURI(text, "text/html"));
+  if (!CefCurrentlyOn(TID_UI))
+  {
+    // |inline_document_| is only touched on the UI thread
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::loadHTML, CefRefPtr<BrowserBridge>(this), std::move(text)));
+    return;
+  }
+  if (!browser_)
+  {
+    return;
+  }
+  inline_document_ = inline_content::Add(std::move(text), "text/html");
+  browser_->GetMainFrame()->LoadURL(inline_document_->url);
+}
+
+void BrowserBridge::setInlineDocument(inline_content::DocumentRef document)
+{
+  CEF_REQUIRE_UI_THREAD();
+  inline_document_ = std::move(document);
 }
 
 void BrowserBridge::scrollUp()
 {
+  EVENT_TRACE_INSTANT(MouseWheel, -100);
   CefMouseEvent ev;
   ev.x = 500;
   ev.y = 500;
-  browser_->GetHost()->SendMouseWheelEvent(ev, 0, -100);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetHost()->SendMouseWheelEvent(ev, 0, -100);
+  }
 }
 
 void BrowserBridge::scrollDown()
 {
+  EVENT_TRACE_INSTANT(MouseWheel, 100);
   CefMouseEvent ev;
   ev.x = 500;
   ev.y = 500;
-  browser_->GetHost()->SendMouseWheelEvent(ev, 0, 100);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetHost()->SendMouseWheelEvent(ev, 0, 100);
+  }
+}
+
+CefSize BrowserBridge::viewSize()
+{
+  std::lock_guard<std::mutex> lock(geometry_mutex_);
+  return view_size_;
 }
 
 void BrowserBridge::changeSize(int w, int h)
 {
-  this->width = w;
-  this->height = h;
-  browser_->GetHost()->WasResized();
+  const auto now = std::chrono::steady_clock::now();
+  uint64_t generation;
+  int delay_ms;
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    requested_size_ = CefSize(w, h);
+    if (!browser_ || hidden_until_sized_)
+    {
+      // nothing painted yet, the first layout uses the size right away
+      view_size_ = requested_size_;
+      if (!browser_ || requested_size_.IsEmpty())
+      {
+        return;
+      }
+      hidden_until_sized_ = false;
+      CefPostTask(TID_UI, base::BindOnce(
+                              [](CefRefPtr<BrowserBridge> bridge)
+                              {
+                                if (bridge->browser_ && !bridge->closing)
+                                {
+                                  bridge->browser_->GetHost()->WasResized();
+                                  bridge->applyVisibility();
+                                }
+                              },
+                              CefRefPtr<BrowserBridge>(this)));
+      return;
+    }
+    if (!resize_pending_)
+    {
+      resize_pending_ = true;
+      resize_deadline_ = now + std::chrono::milliseconds(kMaxResizeLatencyMs);
+    }
+    generation = ++resize_generation_;
+    const auto until_deadline =
+        std::chrono::duration_cast<std::chrono::milliseconds>(resize_deadline_ - now).count();
+    delay_ms = static_cast<int>(std::clamp<int64_t>(until_deadline, 0, kResizeDebounceMs));
+  }
+  CefPostDelayedTask(TID_UI, base::BindOnce(&BrowserBridge::commitResize, CefRefPtr<BrowserBridge>(this), generation), delay_ms);
+}
+
+void BrowserBridge::commitResize(uint64_t generation)
+{
+  CEF_REQUIRE_UI_THREAD();
+  {
+    std::lock_guard<std::mutex> lock(geometry_mutex_);
+    if (!resize_pending_ ||
+        (generation != resize_generation_ && std::chrono::steady_clock::now() < resize_deadline_))
+    {
+      return;
+    }
+    resize_pending_ = false;
+    if (view_size_ == requested_size_)
+    {
+      return;
+    }
+    view_size_ = requested_size_;
+  }
+  TRACE_EVENT0(kTraceCategory, "BrowserBridge::commitResize");
+  if (browser_ && !closing)
+  {
+    browser_->GetHost()->WasResized();
+  }
 }
 
 void BrowserBridge::changeOffset(int x, int y)
@@ -1451,6 +2410,16 @@ void BrowserBridge::changeOffset(int x, int y)
 
 void BrowserBridge::reload(bool ignoreCache)
 {
+  if (!CefCurrentlyOn(TID_UI))
+  {
+    // keeps the order with loadUrl and loadHTML
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::reload, CefRefPtr<BrowserBridge>(this), ignoreCache));
+    return;
+  }
+  if (!browser_)
+  {
+    return;
+  }
   if (ignoreCache)
   {
     browser_->ReloadIgnoreCache();
@@ -1463,31 +2432,94 @@ void BrowserBridge::reload(bool ignoreCache)
 
 void BrowserBridge::setZoomLevel(double level)
 {
-  browser_->GetHost()->SetZoomLevel(level);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetHost()->SetZoomLevel(level);
+  }
+}
+
+void BrowserBridge::applyBatch(const std::vector<BatchCommand> &commands)
+{
+  CEF_REQUIRE_UI_THREAD();
+  TRACE_EVENT1(kTraceCategory, "BrowserBridge::applyBatch", "commands", commands.size());
+  const BatchCommand *size = nullptr;
+  for (const auto &command : commands)
+  {
+    switch (command.type)
+    {
+    case BatchCommand::Type::Size:
+      size = &command;
+      break;
+    case BatchCommand::Type::Offset:
+      changeOffset(command.x, command.y);
+      break;
+    case BatchCommand::Type::Current:
+      isCurrent = command.flag;
+      break;
+    case BatchCommand::Type::Hidden:
+      setHidden(command.flag);
+      break;
+    case BatchCommand::Type::ZoomLevel:
+      if (browser_)
+      {
+        setZoomLevel(command.level);
+      }
+      break;
+    }
+  }
+  if (size)
+  {
+    changeSize(size->x, size->y);
+  }
 }
 
 double BrowserBridge::getZoomLevel()
 {
-  return browser_->GetHost()->GetZoomLevel();
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  return browser ? browser->GetHost()->GetZoomLevel() : 0.0;
 }
 
 void BrowserBridge::executeJavaScript(std::string js)
 {
-  browser_->GetMainFrame()->ExecuteJavaScript(js, browser_->GetMainFrame()->GetURL(), 0);
+  if (!CefCurrentlyOn(TID_UI))
+  {
+    // runs against the page a preceding loadUrl asked for
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::executeJavaScript, CefRefPtr<BrowserBridge>(this), std::move(js)));
+    return;
+  }
+  if (!browser_)
+  {
+    return;
+  }
+  CefRefPtr<CefFrame> frame = browser_->GetMainFrame();
+  frame->ExecuteJavaScript(js, frame->GetURL(), 0);
 }
 
 void BrowserBridge::cursorClick(int x, int y, bool up)
 {
+  EVENT_TRACE_SCOPE1(MouseClick, up);
   CefMouseEvent ev;
   ev.x = x;
   ev.y = y;
-  browser_->GetHost()->SetFocus(true);
-  browser_->GetHost()->SendMouseClickEvent(ev, CefBrowserHost::MouseButtonType::MBT_LEFT, up, 1);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (!browser)
+  {
+    return;
+  }
+  browser->GetHost()->SetFocus(true);
+  browser->GetHost()->SendMouseClickEvent(ev, CefBrowserHost::MouseButtonType::MBT_LEFT, up, 1);
 }
 
 void BrowserBridge::sendKeyEvent(GdkEventKey *event)
 {
-  CefRefPtr<CefBrowserHost> host = browser_->GetHost();
+  EVENT_TRACE_SCOPE1(KeyEvent, event->keyval);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (!browser)
+  {
+    return;
+  }
+  CefRefPtr<CefBrowserHost> host = browser->GetHost();
 
   // Based on WebKeyboardEventBuilder::Build from
   // content/browser/renderer_host/input/web_input_event_builders_gtk.cc.
@@ -1545,9 +2577,14 @@ void BrowserBridge::sendMouseWheelEvent(CefMouseEvent &event,
                                         int deltaX,
                                         int deltaY)
 {
+  EVENT_TRACE_SCOPE1(MouseWheel, deltaY);
   event.x = event.x - current_offset_x;
   event.y = event.y - current_offset_y;
-  browser_->GetHost()->SendMouseWheelEvent(event, deltaX, deltaY);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetHost()->SendMouseWheelEvent(event, deltaX, deltaY);
+  }
 }
 
 void BrowserBridge::sendMouseClickEvent(CefMouseEvent &event,
@@ -1555,41 +2592,266 @@ void BrowserBridge::sendMouseClickEvent(CefMouseEvent &event,
                                         bool mouseUp,
                                         int clickCount)
 {
+  EVENT_TRACE_SCOPE1(MouseClick, mouseUp);
   event.x = event.x - current_offset_x;
   event.y = event.y - current_offset_y;
 
   if (type == MBT_RIGHT && mouseUp == false)
   {
   }
-  browser_->GetHost()->SetFocus(true);
-  browser_->GetHost()->SendMouseClickEvent(event, type, mouseUp, clickCount);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (!browser)
+  {
+    return;
+  }
+  browser->GetHost()->SetFocus(true);
+  browser->GetHost()->SendMouseClickEvent(event, type, mouseUp, clickCount);
 }
 
 void BrowserBridge::sendMouseMoveEvent(CefMouseEvent &event,
                                        bool mouseLeave)
 {
+  EVENT_TRACE_SCOPE(MouseMove);
 
   event.x = event.x - current_offset_x;
   event.y = event.y - current_offset_y;
-  browser_->GetHost()->SendMouseMoveEvent(event, false);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (browser)
+  {
+    browser->GetHost()->SendMouseMoveEvent(event, false);
+  }
 }
 
 void BrowserBridge::setCursorPos(int x, int y)
 {
+  EVENT_TRACE_SCOPE(MouseMove);
   CefMouseEvent ev;
   ev.x = x;
   ev.y = y;
-  browser_->GetHost()->SetFocus(true);
-  browser_->GetHost()->SendMouseMoveEvent(ev, false);
+  CefRefPtr<CefBrowser> browser = currentBrowser();
+  if (!browser)
+  {
+    return;
+  }
+  browser->GetHost()->SendMouseMoveEvent(ev, false);
 }
 
 void BrowserBridge::closeBrowser(bool force)
 {
+  if (!CefCurrentlyOn(TID_UI))
+  {
+    // navigations queued before the close still go through the UI thread
+    CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::closeBrowser, CefRefPtr<BrowserBridge>(this), force));
+    return;
+  }
+  if (!browser_)
+  {
+    return;
+  }
   closing = true;
   browser_->GetHost()->CloseBrowser(force);
 }
 
+CefRefPtr<CefBrowser> BrowserBridge::currentBrowser()
+{
+  std::lock_guard<std::mutex> lock(geometry_mutex_);
+  return browser_;
+}
+
 void BrowserBridge::resetBrowser()
 {
+  performance_interval_ms_ = 0;
+  performance_generation_++;
+  inline_document_ = nullptr;
+  if (devtools_)
+  {
+    devtools_->Detach();
+    devtools_ = nullptr;
+  }
+  ResourceMonitor::GetInstance()->Unregister(texture_id());
+  discardPrerender();
+  std::lock_guard<std::mutex> lock(geometry_mutex_);
   browser_.reset();
+}
+
+CefRefPtr<DevToolsClient> BrowserBridge::getDevTools()
+{
+  if (!devtools_ && browser_ && !closing)
+  {
+    devtools_ = new DevToolsClient(browser_);
+  }
+  return devtools_;
+}
+
+void BrowserBridge::sampleUsage()
+{
+  ResourceMonitor::GetInstance()->SetRasterPixels(texture_id(), raster_pixels);
+  auto devtools = getDevTools();
+  if (!devtools)
+  {
+    return;
+  }
+  const int64_t id = texture_id();
+  devtools->Execute("Runtime.getHeapUsage", nullptr,
+                    [id](bool success, CefRefPtr<CefDictionaryValue> result)
+                    {
+                      if (success)
+                      {
+                        ResourceMonitor::GetInstance()->SetHeapUsage(
+                            id,
+                            static_cast<int64_t>(result->GetDouble("usedSize")),
+                            static_cast<int64_t>(result->GetDouble("totalSize")));
+                      }
+                    });
+}
+
+FlValue *BrowserBridge::getResourceUsage()
+{
+  ResourceUsage usage = ResourceMonitor::GetInstance()->GetUsage(texture_id()).value_or(ResourceUsage());
+  usage.paint_count = paint_count;
+  usage.paint_bytes = paint_bytes;
+
+  FlValue *value = fl_value_new_map();
+  fl_value_set_string_take(value, "rendererPid", fl_value_new_int(usage.renderer_pid));
+  fl_value_set_string_take(value, "cpuTimeMs", fl_value_new_float(usage.cpu_time_ms));
+  fl_value_set_string_take(value, "cpuPercent", fl_value_new_float(usage.cpu_percent));
+  fl_value_set_string_take(value, "rssBytes", fl_value_new_int(usage.rss_bytes));
+  fl_value_set_string_take(value, "jsHeapUsed", fl_value_new_int(usage.js_heap_used));
+  fl_value_set_string_take(value, "jsHeapTotal", fl_value_new_int(usage.js_heap_total));
+  fl_value_set_string_take(value, "paintCount", fl_value_new_int(usage.paint_count));
+  fl_value_set_string_take(value, "paintBytes", fl_value_new_int(usage.paint_bytes));
+  fl_value_set_string_take(value, "discardedFrames", fl_value_new_int(discarded_frames));
+  fl_value_set_string_take(value, "rasterPixels", fl_value_new_int(raster_pixels));
+  fl_value_set_string_take(value, "rasterPixelsPerSecond", fl_value_new_float(usage.raster_pixels_per_second));
+  fl_value_set_string_take(value, "paintScale", fl_value_new_float(paintScale()));
+  fl_value_set_string_take(value, "bufferReleases", fl_value_new_int(buffer_releases));
+  fl_value_set_string_take(value, "releasedBufferBytes",
+                           fl_value_new_int(released_buffer_bytes + video_outlet_released_previous_bytes(texture_bridge)));
+  fl_value_set_string_take(value, "snapshotBytes", fl_value_new_int(snapshot_bytes));
+  if (usage.performance)
+  {
+    const auto &metrics = *usage.performance;
+    FlValue *performance = fl_value_new_map();
+    fl_value_set_string_take(performance, "layoutCount", fl_value_new_int(metrics.layout_count));
+    fl_value_set_string_take(performance, "recalcStyleCount", fl_value_new_int(metrics.recalc_style_count));
+    fl_value_set_string_take(performance, "layoutDurationMs", fl_value_new_float(metrics.layout_duration_ms));
+    fl_value_set_string_take(performance, "recalcStyleDurationMs", fl_value_new_float(metrics.recalc_style_duration_ms));
+    fl_value_set_string_take(performance, "scriptDurationMs", fl_value_new_float(metrics.script_duration_ms));
+    fl_value_set_string_take(performance, "taskDurationMs", fl_value_new_float(metrics.task_duration_ms));
+    fl_value_set_string_take(performance, "jsHeapUsed", fl_value_new_int(metrics.js_heap_used));
+    fl_value_set_string_take(performance, "jsHeapTotal", fl_value_new_int(metrics.js_heap_total));
+    fl_value_set_string_take(performance, "nodes", fl_value_new_int(metrics.nodes));
+    fl_value_set_string_take(value, "performance", performance);
+  }
+  return value;
+}
+
+void BrowserBridge::setPerformanceMetricsInterval(int interval_ms)
+{
+  CEF_REQUIRE_UI_THREAD();
+  const bool was_enabled = performance_interval_ms_ > 0;
+  performance_interval_ms_ = interval_ms > 0 ? interval_ms : 0;
+  performance_generation_++;
+
+  auto devtools = getDevTools();
+  if (!devtools)
+  {
+    return;
+  }
+  if (performance_interval_ms_ == 0)
+  {
+    if (was_enabled)
+    {
+      devtools->Execute("Performance.disable", nullptr, nullptr);
+      ResourceMonitor::GetInstance()->SetPerformanceMetrics(texture_id(), std::nullopt);
+    }
+    return;
+  }
+  if (!was_enabled)
+  {
+    CefRefPtr<CefDictionaryValue> params = CefDictionaryValue::Create();
+    params->SetString("timeDomain", "timeTicks");
+    devtools->Execute("Performance.enable", params, nullptr);
+  }
+  samplePerformanceMetrics(performance_generation_);
+}
+
+void BrowserBridge::samplePerformanceMetrics(int generation)
+{
+  CEF_REQUIRE_UI_THREAD();
+  if (generation != performance_generation_ || performance_interval_ms_ == 0)
+  {
+    return;
+  }
+  auto devtools = getDevTools();
+  if (!devtools)
+  {
+    return;
+  }
+  CefRefPtr<BrowserBridge> self(this);
+  devtools->Execute("Performance.getMetrics", nullptr,
+                    [self, generation](bool success, CefRefPtr<CefDictionaryValue> result)
+                    {
+                      if (!success || generation != self->performance_generation_)
+                      {
+                        return;
+                      }
+                      // metrics come as a list of {name, value}, durations in seconds
+                      PerformanceMetrics metrics;
+                      CefRefPtr<CefListValue> list = result->GetList("metrics");
+                      for (size_t i = 0; list && i < list->GetSize(); i++)
+                      {
+                        CefRefPtr<CefDictionaryValue> metric = list->GetDictionary(i);
+                        const std::string name = metric->GetString("name");
+                        const double value = metric->GetDouble("value");
+                        if (name == "LayoutCount")
+                          metrics.layout_count = static_cast<int64_t>(value);
+                        else if (name == "RecalcStyleCount")
+                          metrics.recalc_style_count = static_cast<int64_t>(value);
+                        else if (name == "LayoutDuration")
+                          metrics.layout_duration_ms = value * 1000;
+                        else if (name == "RecalcStyleDuration")
+                          metrics.recalc_style_duration_ms = value * 1000;
+                        else if (name == "ScriptDuration")
+                          metrics.script_duration_ms = value * 1000;
+                        else if (name == "TaskDuration")
+                          metrics.task_duration_ms = value * 1000;
+                        else if (name == "JSHeapUsedSize")
+                          metrics.js_heap_used = static_cast<int64_t>(value);
+                        else if (name == "JSHeapTotalSize")
+                          metrics.js_heap_total = static_cast<int64_t>(value);
+                        else if (name == "Nodes")
+                          metrics.nodes = static_cast<int64_t>(value);
+                      }
+                      self->OnPerformanceMetrics(metrics);
+                    });
+  CefPostDelayedTask(TID_UI, base::BindOnce(&BrowserBridge::samplePerformanceMetrics, CefRefPtr<BrowserBridge>(this), generation),
+                     performance_interval_ms_);
+}
+
+void BrowserBridge::OnPerformanceMetrics(const PerformanceMetrics &metrics)
+{
+  ResourceMonitor::GetInstance()->SetPerformanceMetrics(texture_id(), metrics);
+
+  // sent as a flat list to keep the per-interval event small, the order is
+  // mirrored by PerformanceMetrics.fromList on the Dart side
+  const double values[] = {
+      static_cast<double>(metrics.layout_count),
+      static_cast<double>(metrics.recalc_style_count),
+      metrics.layout_duration_ms,
+      metrics.recalc_style_duration_ms,
+      metrics.script_duration_ms,
+      metrics.task_duration_ms,
+      static_cast<double>(metrics.js_heap_used),
+      static_cast<double>(metrics.js_heap_total),
+      static_cast<double>(metrics.nodes),
+  };
+  g_autoptr(FlValue) message = fl_value_new_map();
+  fl_value_set_string_take(message, kEventType, fl_value_new_string("performanceMetrics"));
+  fl_value_set_string_take(message, kEventValue, fl_value_new_float_list(values, G_N_ELEMENTS(values)));
+  g_autoptr(GError) error = NULL;
+  if (!sendEvent(message, &error))
+  {
+    g_warning("Failed to send performanceMetrics event: %s", error->message);
+  }
 }
\ No newline at end of file
@@ -10,8 +10,16 @@
 #include <flutter_linux/flutter_linux.h>
 
 #include "video_outlet.h"
+#include "cache_metrics.h"
+#include "network_timing.h"
+#include "devtools_client.h"
+#include "inline_content.h"
+#include "resource_monitor.h"
 
 #include <gdk/gdkx.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 struct BrowserStartParams
 { // Structure declaration
@@ -21,9 +29,36 @@ struct BrowserStartParams
     CefString access_token;
     int64_t texture_id;
     GtkWidget* parent;
+    // browsers with the same key share a request context, see request_contexts.h
+    std::string context_key;
+    bool persist_context = false;
 };
 
-void newBrowserInstance(int64_t texture_id, const CefString &initialUrl, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget* parent);
+// One step of an applyBatch call, see BrowserCommand on the Dart side.
+struct BatchCommand
+{
+    enum class Type
+    {
+        Size,
+        Offset,
+        Current,
+        Hidden,
+        ZoomLevel,
+    };
+    Type type;
+    // width and height for Size
+    int x = 0;
+    int y = 0;
+    bool flag = false;
+    double level = 0;
+};
+
+// Respond to a deferred |method_call| on the platform thread. Takes the
+// references to |method_call| and |response|.
+void respondOnMainThread(FlMethodCall *method_call, FlMethodResponse *response);
+
+void newBrowserInstance(int64_t texture_id, const CefString &initialUrl, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget* parent,
+                        const std::string &context_key, bool persist_context);
 
 class BrowserBridge : public virtual CefBaseRefCounted
 {
@@ -36,17 +71,96 @@ public:
 
     void resetBrowser();
 
+    int64_t texture_id() const { return params.texture_id; }
+
+    const std::string &context_key() const { return params.context_key; }
+
+    // Must be called before the browser is created.
+    void setRequestContext(const std::string &key, bool persistent);
+
+    // Delivers events to the Dart port |port| instead of the event channel,
+    // see native_port.h. Must be called before the browser is created.
+    void setEventPort(int64_t port);
+
+    // Sends |count| eventProbe events stamped with the wall clock time in
+    // microseconds to measure the delivery latency. Must be called on the UI
+    // thread.
+    void sendEventProbes(int count);
+
     void send_buffer(bool pet, const void *buffer, int32_t width, int32_t height);
 
-    uint32_t width = 1920;
-    uint32_t height = 1080;
+    // Draws popups such as select dropdowns into the view texture instead of
+    // the popup texture, no popupShow and popupSize events are sent then.
+    // Must be called before the browser is created.
+    void setPopupCompositing(bool enabled);
+
+    bool compositesPopup() const { return composite_popup_; }
+
+    // Composite mode replacement of send_buffer, updates only the dirty
+    // rects of view frames. Called on the UI thread.
+    void compositeFrame(CefRenderHandler::PaintElementType type,
+                        const CefRenderHandler::RectList &dirty_rects,
+                        const void *buffer, int width, int height);
+
+    // Size the page is laid out at, empty until the first size is known.
+    // Safe to call from any thread.
+    CefSize viewSize();
+
+    // Lays the first page out at |width| x |height| logical pixels instead
+    // of waiting for the first changeSize. Must be called before the browser
+    // is created.
+    void setInitialSize(int width, int height, double device_scale);
+
+    // Returns whether a view frame of |width| x |height| pixels matches the
+    // view size, counts it as discarded otherwise. Called on the UI thread.
+    bool acceptViewFrame(int width, int height);
+
+    // Device pixels per logical pixel the page is painted at, the device
+    // scale times the render scale. Safe to call from any thread.
+    double paintScale();
+
+    // Paints at |scale| of the device resolution, clamped to 0.25 to 1, and
+    // lets the texture stretch the frames. Must be called on the UI thread.
+    void setRenderScale(double scale);
+
+    // Paints at |ratio| device pixels per logical pixel, e.g. after the
+    // window moved to a display of another scale. Must be called on the UI
+    // thread.
+    void setDevicePixelRatio(double ratio);
+
+    // Keeps a frame downscaled by |divisor| when the buffers of a hidden
+    // browser are released, shown until the first paint after it is shown
+    // again. 0 drops the frame entirely. Must be called on the UI thread.
+    void setHiddenSnapshot(int divisor);
 
     int32_t current_offset_x = 0;
     int32_t current_offset_y = 0;
 
-    bool isCurrent = false;
+    // set on the platform thread or by applyBatch, read by the input routing
+    std::atomic<bool> isCurrent{false};
+
+    // frames delivered by OnPaint, read by the resource monitor
+    std::atomic<uint64_t> paint_count{0};
+    std::atomic<uint64_t> paint_bytes{0};
+    // view frames dropped because they were painted for another size
+    std::atomic<uint64_t> discarded_frames{0};
+    // dirty pixels of the view frames delivered by OnPaint
+    std::atomic<uint64_t> raster_pixels{0};
+    // frame buffers released while hidden and the bytes they held, the
+    // outlet adds its upload copies once Flutter let go of them
+    std::atomic<uint64_t> buffer_releases{0};
+    std::atomic<uint64_t> released_buffer_bytes{0};
+    // size of the snapshot kept instead, 0 once a frame replaced it. Does not
+    // include the copy Flutter uploads from.
+    std::atomic<uint64_t> snapshot_bytes{0};
+
     VideoOutlet *texture_bridge;
-    VideoOutlet *texture_bridge_pet;
+    // created when a popup first shows and released a while after it
+    // closed, only touched on the UI thread
+    VideoOutlet *texture_bridge_pet = nullptr;
+
+    // texture id of |texture_bridge_pet|, 0 while there is none
+    std::atomic<int64_t> pet_texture_id{0};
 
     void OnAfterCreated();
 
@@ -61,6 +175,11 @@ public:
 
     void clearAllCookies();
 
+    // Sends the cache counters of the page load that just finished.
+    void OnCacheStats(const cache_metrics::PageStats &stats);
+
+    void OnNetworkTiming(const network_timing::Page &page);
+
     void OnTitleChanged(const CefString &title);
 
     void OnUrlChanged(const CefString &url);
@@ -69,6 +188,11 @@ public:
 
     void onPopupShow(bool show);
 
+    // Hides or shows the page. The view texture buffers are freed once it
+    // stayed hidden for a while and the page repaints when shown again.
+    // Must be called on the UI thread.
+    void setHidden(bool hidden);
+
     void OnPopupSize(int x,
                      int y,
                      int width,
@@ -78,16 +202,32 @@ public:
 
     void scrollDown();
 
+    // Requests a new view size from any thread. Requests are coalesced and
+    // the page is laid out again once they stop for a moment, or at the
+    // latest 150 ms after the first one while they keep coming. Until then
+    // the texture keeps the last frame, which Flutter stretches to the new
+    // size.
     void changeSize(int width, int height);
 
     void changeOffset(int x, int y);
 
     void cursorClick(int x, int y, bool up);
 
+    // Navigates, or shows the prerendered page if it was prepared for |url|.
     void loadUrl(const CefString &url);
 
+    // Loads |url| in a hidden companion browser sharing this browser's
+    // request context, replacing an earlier one. An empty url drops it.
+    // Must be called on the UI thread.
+    void prerender(const std::string &url);
+
+    // Posts itself to the UI thread when called elsewhere.
     void loadHTML(std::string text);
 
+    // Keep |document| alive while it is shown, replaced by the next load.
+    // Must be called on the UI thread.
+    void setInlineDocument(inline_content::DocumentRef document);
+
     void browserEvent(WebviewEvent event);
 
     void sendKeyEvent(GdkEventKey *event);
@@ -106,6 +246,10 @@ public:
 
     void setZoomLevel(double level);
 
+    // Applies |commands| in order in one UI thread task, the browser is
+    // resized at most once. Must be called on the UI thread.
+    void applyBatch(const std::vector<BatchCommand> &commands);
+
     void textSelectionReport(const CefString &url);
 
     double getZoomLevel();
@@ -124,22 +268,127 @@ public:
 
     void setAccessToken(std::string token);
 
+    // Store the raster pixel count and request Runtime.getHeapUsage for the
+    // resource monitor. Must be called on the UI thread.
+    void sampleUsage();
+
+    // Returns a new map with the latest resource usage of this browser.
+    FlValue *getResourceUsage();
+
+    // Enable the DevTools Performance domain and send a performanceMetrics
+    // event every |interval_ms|, 0 disables it again. Must be called on the
+    // UI thread.
+    void setPerformanceMetricsInterval(int interval_ms);
+
+    // Lazily created DevTools protocol client. Must be called on the UI thread.
+    CefRefPtr<DevToolsClient> getDevTools();
+
+    // Copy of |browser_| for callers off the UI thread, null until the
+    // browser is created.
+    CefRefPtr<CefBrowser> currentBrowser();
+
     bool closing = false;
 
+    // Only read directly on the UI thread, swapped under |geometry_mutex_|.
     CefRefPtr<CefBrowser> browser_;
 
 private:
 
     void OnWebviewStateChange(WebviewState state);
 
+    void sendPopupShow(bool show);
+
+    // Registers the popup outlet with the engine, runs on the main thread.
+    void registerPopupOutlet(VideoOutlet *outlet);
+
+    // Drop the outlet buffers unless they were used again since
+    // |generation|. Called on the UI thread.
+    void releasePopupOutlet(int generation);
+    void releaseViewBuffers(int generation);
+
+    // Shows the browser unless the app hid it or no size is known yet, the
+    // only place that calls WasHidden. Called on the UI thread.
+    void applyVisibility();
+
+    int popup_outlet_generation_ = 0;
+    int view_outlet_generation_ = 0;
+    bool hidden_ = false;
+    bool view_buffers_released_ = false;
+    int hidden_snapshot_divisor_ = 0;
+
+    // Converts |rect| of |view_pixels_| into the view texture.
+    void restoreViewRect(VideoOutletPrivate *outlet, const CefRect &rect);
+
+    // Converts the popup frame into the view texture at |popup_rect_|.
+    void drawPopup(VideoOutletPrivate *outlet);
+
+    bool composite_popup_ = false;
+
+    // BGRA copy of the last view frame, the texture under a closing popup is
+    // restored from it
+    std::vector<uint8_t> view_pixels_;
+    CefSize view_pixels_size_;
+
+    std::vector<uint8_t> popup_pixels_;
+    CefSize popup_pixels_size_;
+
+    // in view pixels
+    CefRect popup_rect_;
+    bool popup_visible_ = false;
+
+    // Sends |message| through the event port if set, the event channel
+    // otherwise.
+    gboolean sendEvent(FlValue *message, GError **error);
+
     FlEventChannel *event_channel_;
 
+    int64_t event_port_ = 0;
+
     FlMethodChannel *method_channel_;
     void HandleMethodCall(
         FlMethodCall *method_call);
 
     FlTextureRegistrar *texture_registrar_;
 
+    CefRefPtr<DevToolsClient> devtools_;
+
+    inline_content::DocumentRef inline_document_;
+
+    void samplePerformanceMetrics(int generation);
+
+    void OnPerformanceMetrics(const PerformanceMetrics &metrics);
+
+    // Puts the companion in place of |browser_| if it was prepared for |url|.
+    bool swapInPrerendered(const CefString &url);
+
+    void discardPrerender();
+
+    CefRefPtr<CefBrowser> prerender_;
+
+    std::string prerender_url_;
+
+    // Applies the latest requested size unless a newer request is still
+    // within the debounce window. Called on the UI thread.
+    void commitResize(uint64_t generation);
+
+    // guards the sizes below and swaps of |browser_|, changeSize is called
+    // from the platform thread
+    std::mutex geometry_mutex_;
+    CefSize view_size_;
+    CefSize requested_size_;
+    double device_scale_ = 1.0;
+    double render_scale_ = 1.0;
+    // the browser is kept hidden until a size is known
+    bool hidden_until_sized_ = false;
+    bool resize_pending_ = false;
+    uint64_t resize_generation_ = 0;
+    std::chrono::steady_clock::time_point resize_deadline_;
+
+    int performance_interval_ms_ = 0;
+
+    // bumped whenever sampling is reconfigured, stale delayed samples bail out
+    int performance_generation_ = 0;
+
     void *latestPetBuffer;
 
     void *latestMainBuffer;
@@ -7,7 +7,11 @@
 #include "include/cef_command_line.h"
 #include "include/cef_crash_util.h"
 #include "include/cef_file_util.h"
+#include "include/cef_scheme.h"
+#include "asset_pack.h"
 #include "client_switches.h"
+#include "inline_content.h"
+#include "webview.h"
 
 namespace client
 {
@@ -24,6 +28,10 @@ namespace client
 
                 void OnContextInitialized(CefRefPtr<ClientAppBrowser> app) override
                 {
+                    CefRegisterSchemeHandlerFactory(kAppScheme, inline_content::kHost,
+                                                    inline_content::CreateSchemeHandlerFactory());
+                    CefRegisterSchemeHandlerFactory(kAppScheme, asset_pack::kHost,
+                                                    asset_pack::CreateSchemeHandlerFactory());
                 }
 
                 void OnBeforeCommandLineProcessing(
@@ -0,0 +1,105 @@
+#include "cache_metrics.h"
+
+#include <atomic>
+#include <map>
+
+#include "include/wrapper/cef_helpers.h"
+
+#include "devtools_client.h"
+
+namespace cache_metrics
+{
+  namespace
+  {
+    std::atomic<bool> g_enabled{false};
+
+    struct Entry
+    {
+      CefRefPtr<DevToolsClient> devtools;
+      PageStats stats;
+    };
+
+    // Map of browser id -> observer and counters of the current page load
+    std::map<int, Entry> g_entries;
+
+    void OnNetworkEvent(int browser_id, const std::string &method, CefRefPtr<CefDictionaryValue> params)
+    {
+      auto it = g_entries.find(browser_id);
+      if (it == g_entries.end())
+      {
+        return;
+      }
+      PageStats &stats = it->second.stats;
+      if (method == "Network.requestServedFromCache")
+      {
+        // memory cache hit, counted as a request by its responseReceived
+        stats.cached_requests++;
+      }
+      else if (method == "Network.responseReceived")
+      {
+        stats.requests++;
+        CefRefPtr<CefDictionaryValue> response = params->GetDictionary("response");
+        if (response && (response->GetBool("fromDiskCache") || response->GetBool("fromPrefetchCache")))
+        {
+          stats.cached_requests++;
+        }
+      }
+      else if (method == "Network.loadingFinished")
+      {
+        stats.network_bytes += static_cast<int64_t>(params->GetDouble("encodedDataLength"));
+      }
+    }
+  }
+
+  void SetEnabled(bool enabled)
+  {
+    g_enabled = enabled;
+  }
+
+  void Attach(CefRefPtr<CefBrowser> browser)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    if (!g_enabled)
+    {
+      return;
+    }
+    const int browser_id = browser->GetIdentifier();
+    Entry &entry = g_entries[browser_id];
+    entry.devtools = new DevToolsClient(browser);
+    entry.devtools->SetEventCallback([browser_id](const std::string &method, CefRefPtr<CefDictionaryValue> params)
+                                     { OnNetworkEvent(browser_id, method, params); });
+    entry.devtools->Execute("Network.enable", nullptr, nullptr);
+  }
+
+  void Detach(int browser_id)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    auto it = g_entries.find(browser_id);
+    if (it != g_entries.end())
+    {
+      it->second.devtools->Detach();
+      g_entries.erase(it);
+    }
+  }
+
+  void OnLoadStart(int browser_id)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    auto it = g_entries.find(browser_id);
+    if (it != g_entries.end())
+    {
+      it->second.stats = PageStats();
+    }
+  }
+
+  std::optional<PageStats> OnLoadEnd(int browser_id)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    auto it = g_entries.find(browser_id);
+    if (it == g_entries.end())
+    {
+      return std::nullopt;
+    }
+    return it->second.stats;
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "include/cef_browser.h"
+
+// Counts how many requests of a page load were answered from the memory or
+// disk cache. Uses the DevTools Network domain, so it is only attached to
+// browsers created while it is enabled. Everything runs on the UI thread.
+namespace cache_metrics
+{
+  struct PageStats
+  {
+    uint32_t requests = 0;
+    uint32_t cached_requests = 0;
+    // encoded bytes that came over the network
+    int64_t network_bytes = 0;
+  };
+
+  void SetEnabled(bool enabled);
+
+  void Attach(CefRefPtr<CefBrowser> browser);
+
+  void Detach(int browser_id);
+
+  // Starts counting a new page load.
+  void OnLoadStart(int browser_id);
+
+  // Returns the counters of the finished page load.
+  std::optional<PageStats> OnLoadEnd(int browser_id);
+}
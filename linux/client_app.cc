@@ -5,6 +5,9 @@
 #include "client_app.h"
 
 #include "include/cef_command_line.h"
+#include "include/cef_scheme.h"
+
+#include "webview.h"
 
 namespace client {
 
@@ -39,4 +42,12 @@ ClientApp::ProcessType ClientApp::GetProcessType(
   return OtherProcess;
 }
 
+void ClientApp::OnRegisterCustomSchemes(
+    CefRawPtr<CefSchemeRegistrar> registrar) {
+  registrar->AddCustomScheme(
+      kAppScheme, CEF_SCHEME_OPTION_STANDARD | CEF_SCHEME_OPTION_SECURE |
+                      CEF_SCHEME_OPTION_CORS_ENABLED |
+                      CEF_SCHEME_OPTION_FETCH_ENABLED);
+}
+
 }  // 
\ No newline at end of file
@@ -27,6 +27,10 @@ class ClientApp : public CefApp {
   // Determine the process type based on command-line arguments.
   static ProcessType GetProcessType(CefRefPtr<CefCommandLine> command_line);
 
+  // Registers the plugin's scheme, called in every process.
+  void OnRegisterCustomSchemes(
+      CefRawPtr<CefSchemeRegistrar> registrar) override;
+
  private:
 
   DISALLOW_COPY_AND_ASSIGN(ClientApp);
@@ -4,8 +4,12 @@
 
 #include "client_browser.h"
 
+#include <cstdlib>
+#include <string>
+
 #include "include/base/cef_logging.h"
 #include "include/cef_cookie.h"
+#include "async_log.h"
 #include "client_switches.h"
 
 namespace client
@@ -26,6 +30,16 @@ namespace client
     command_line->AppendSwitch("ignore-certificate-errors");
     command_line->AppendSwitch("enable-system-flash");
 
+    // CEF has no setting for the http cache size
+    if (command_line->HasSwitch(switches::kCacheMaxSize))
+    {
+      const int64_t megabytes = std::strtoll(command_line->GetSwitchValue(switches::kCacheMaxSize).ToString().c_str(), nullptr, 10);
+      if (megabytes > 0)
+      {
+        command_line->AppendSwitchWithValue("disk-cache-size", std::to_string(megabytes * 1024 * 1024));
+      }
+    }
+
 #if defined(OS_MAC)
     // Disable the toolchain prompt on macO for future use
     command_line->AppendSwitch("use-mock-keychain");
@@ -38,7 +52,7 @@ namespace client
 
   void ClientAppBrowser::OnContextInitialized()
   {
-    LOG(INFO) << "onContextInititalized " << delegates_.size();
+    ALOG(Info, "onContextInititalized {}", delegates_.size());
     DelegateSet::iterator it = delegates_.begin();
     for (; it != delegates_.end(); ++it)
       (*it)->OnContextInitialized(this);
@@ -47,6 +61,16 @@ namespace client
   void ClientAppBrowser::OnBeforeChildProcessLaunch(
       CefRefPtr<CefCommandLine> command_line)
   {
+    // child processes log into the same file at the same level
+    CefRefPtr<CefCommandLine> global = CefCommandLine::GetGlobalCommandLine();
+    for (const char *name : {switches::kLogFile, switches::kLogLevel})
+    {
+      if (global->HasSwitch(name) && !command_line->HasSwitch(name))
+      {
+        command_line->AppendSwitchWithValue(name, global->GetSwitchValue(name));
+      }
+    }
+
     DelegateSet::iterator it = delegates_.begin();
     for (; it != delegates_.end(); ++it)
       (*it)->OnBeforeChildProcessLaunch(this, command_line);
@@ -51,6 +51,11 @@ const char kInitialShowState[] = "initial-show-state";
 const char kHideChromeStatusBubble[] = "hide-chrome-status-bubble";
 const char kUseDefaultPopup[] = "use-default-popup";
 const char kUseClientDialogs[] = "use-client-dialogs";
+const char kLogFile[] = "dart-cef-log-file";
+const char kLogLevel[] = "dart-cef-log-level";
+const char kRootCachePath[] = "dart-cef-root-cache-path";
+const char kDartCefCachePath[] = "dart-cef-cache-path";
+const char kCacheMaxSize[] = "dart-cef-cache-max-mb";
 
 }  // namespace switches
 }  // namespace client
\ No newline at end of file
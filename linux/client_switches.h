@@ -45,6 +45,11 @@ extern const char kInitialShowState[];
 extern const char kHideChromeStatusBubble[];
 extern const char kUseDefaultPopup[];
 extern const char kUseClientDialogs[];
+extern const char kLogFile[];
+extern const char kLogLevel[];
+extern const char kRootCachePath[];
+extern const char kDartCefCachePath[];
+extern const char kCacheMaxSize[];
 
 }  // namespace switches
 }  // namespace client
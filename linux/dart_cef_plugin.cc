@@ -17,6 +17,10 @@
 #include "include/base/cef_logging.h"
 #include "include/cef_app.h"
 #include "include/cef_command_line.h"
+#include "include/cef_trace.h"
+#include "include/base/cef_callback.h"
+#include "include/base/cef_trace_event.h"
+#include "include/wrapper/cef_closure_task.h"
 #include "include/wrapper/cef_helpers.h"
 #include "client_browser.h"
 #include "main_message_loop_multithreaded_gtk.h"
@@ -24,7 +28,15 @@
 #include "client_app_other.h"
 #include "client_switches.h"
 #include "client_renderer.h"
-#include "data.h"
+#include "asset_pack.h"
+#include "async_log.h"
+#include "inline_content.h"
+#include "cache_metrics.h"
+#include "event_tracer.h"
+#include "native_port.h"
+#include "request_contexts.h"
+#include "resource_monitor.h"
+#include "response_cache.h"
 #include "simple_handler.h"
 
 #define DART_CEF_PLUGIN(obj)                                     \
@@ -61,12 +73,22 @@ namespace client
       CefRefPtr<CefCommandLine> command_line = CefCommandLine::CreateCommandLine();
       command_line->InitFromArgv(argc, argv);
 
+      // Every process logs through the async logger, child processes inherit
+      // the switches in ClientAppBrowser::OnBeforeChildProcessLaunch. Init
+      // only opens the file, see async_log::Init.
+      std::string log_file = command_line->GetSwitchValue(switches::kLogFile);
+      if (log_file.empty())
+      {
+        log_file = "webview_cef.log";
+      }
+      const auto log_level = async_log::ParseLevel(command_line->GetSwitchValue(switches::kLogLevel), async_log::Level::Info);
+      async_log::Init(log_file, log_level);
+
       // Create a ClientApp of the correct type.
       CefRefPtr<CefApp> app;
       ClientApp::ProcessType process_type = ClientApp::GetProcessType(command_line);
       if (process_type == ClientApp::BrowserProcess)
       {
-        std::cout << "browser process!" << std::endl;
         app = new ClientAppBrowser();
       }
       else if (process_type == ClientApp::RendererProcess ||
@@ -87,13 +109,54 @@ namespace client
       if (exit_code >= 0)
         return exit_code;
 
+      // nothing is logged before CefExecuteProcess, the first message starts
+      // the writer thread and the zygote must still be single threaded when
+      // it forks
+      ALOG(Info, "browser process!");
+
       CefSettings settings;
 
       settings.no_sandbox = true;
       settings.windowless_rendering_enabled = true;
       settings.multi_threaded_message_loop = true;
       settings.remote_debugging_port = 8088;
-      CefString(&settings.log_file).FromASCII("webview_cef.log");
+
+      // CefInitialize runs before Dart, so the profile locations come from
+      // the command line. Without a cache path the global context stays in
+      // memory, Dart can still create on-disk contexts below the root.
+      std::string root_cache_path = command_line->GetSwitchValue(switches::kRootCachePath);
+      if (root_cache_path.empty())
+      {
+        const gchar *name = g_get_prgname();
+        root_cache_path = std::string(g_get_user_cache_dir()) + "/" + (name ? name : "dart_cef") + "/cef";
+      }
+      CefString(&settings.root_cache_path).FromString(root_cache_path);
+      request_contexts::SetRootCachePath(root_cache_path);
+      const std::string cache_path = command_line->GetSwitchValue(switches::kDartCefCachePath);
+      if (!cache_path.empty())
+      {
+        CefString(&settings.cache_path).FromString(cache_path[0] == '/' ? cache_path : root_cache_path + "/" + cache_path);
+        settings.persist_session_cookies = true;
+      }
+      CefString(&settings.log_file).FromString(log_file);
+      switch (log_level)
+      {
+      case async_log::Level::Debug:
+        settings.log_severity = LOGSEVERITY_VERBOSE;
+        break;
+      case async_log::Level::Info:
+        settings.log_severity = LOGSEVERITY_INFO;
+        break;
+      case async_log::Level::Warning:
+        settings.log_severity = LOGSEVERITY_WARNING;
+        break;
+      case async_log::Level::Error:
+        settings.log_severity = LOGSEVERITY_ERROR;
+        break;
+      default:
+        settings.log_severity = LOGSEVERITY_DISABLE;
+        break;
+      }
 
       if (settings.windowless_rendering_enabled)
       {
@@ -123,6 +186,69 @@ namespace client
     {
       return parent;
     }
+
+    class TracingStartCallback : public CefCompletionCallback
+    {
+    public:
+      explicit TracingStartCallback(FlMethodCall *method_call) : method_call_(method_call) {}
+
+      void OnComplete() override
+      {
+        respondOnMainThread(method_call_, FL_METHOD_RESPONSE(fl_method_success_response_new(NULL)));
+      }
+
+    private:
+      FlMethodCall *method_call_;
+
+      IMPLEMENT_REFCOUNTING(TracingStartCallback);
+    };
+
+    class TracingEndCallback : public CefEndTracingCallback
+    {
+    public:
+      explicit TracingEndCallback(FlMethodCall *method_call) : method_call_(method_call) {}
+
+      void OnEndTracingComplete(const CefString &tracing_file) override
+      {
+        g_autoptr(FlValue) result = fl_value_new_string(tracing_file.ToString().c_str());
+        respondOnMainThread(method_call_, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+      }
+
+    private:
+      FlMethodCall *method_call_;
+
+      IMPLEMENT_REFCOUNTING(TracingEndCallback);
+    };
+
+    // Takes a reference to |method_call|, released when the response is sent.
+    void startTracing(FlMethodCall *method_call, const std::string &categories)
+    {
+      if (!CefCurrentlyOn(TID_UI))
+      {
+        CefPostTask(TID_UI, base::BindOnce(startTracing, method_call, categories));
+        return;
+      }
+      if (!CefBeginTracing(categories, new TracingStartCallback(method_call)))
+      {
+        respondOnMainThread(method_call, FL_METHOD_RESPONSE(fl_method_error_response_new(
+                                             "tracingFailed", "tracing is already running", nullptr)));
+      }
+    }
+
+    // Takes a reference to |method_call|, released when the response is sent.
+    void stopTracing(FlMethodCall *method_call, const std::string &path)
+    {
+      if (!CefCurrentlyOn(TID_UI))
+      {
+        CefPostTask(TID_UI, base::BindOnce(stopTracing, method_call, path));
+        return;
+      }
+      if (!CefEndTracing(path, new TracingEndCallback(method_call)))
+      {
+        respondOnMainThread(method_call, FL_METHOD_RESPONSE(fl_method_error_response_new(
+                                             "tracingFailed", "tracing is not running", nullptr)));
+      }
+    }
   }
 }
 
@@ -162,6 +288,8 @@ static void dart_cef_plugin_handle_method_call(
 
   const gchar *method = fl_method_call_get_name(method_call);
   FlValue *args = fl_method_call_get_args(method_call);
+  TRACE_EVENT_COPY_BEGIN0(kTraceCategory, method);
+  EVENT_TRACE_SCOPE(MethodCall);
 
   if (strcmp(method, "getPlatformVersion") == 0)
   {
@@ -183,13 +311,37 @@ static void dart_cef_plugin_handle_method_call(
         fl_value_lookup_string(args, "accessToken"));
     bool is_string = fl_value_get_bool(
         fl_value_lookup_string(args, "isHTML"));
+    FlValue *context_key = fl_value_lookup_string(args, "contextKey");
+    FlValue *persist_context = fl_value_lookup_string(args, "persistContext");
+    inline_content::DocumentRef document;
     if (is_string)
     {
-      url = GetDataURI(url, "text/html");
+      document = inline_content::Add(std::move(url), "text/html");
+      url = document->url;
     }
 
-    int64_t texture_id = handler->createBrowser(self->messenger, self->texture_registrar, url, bind_func, token, access_token, client::getParent());
-    LOG(INFO) << "Create browser request for " << texture_id << " texture and url " << url;
+    int64_t texture_id = handler->createBrowser(self->messenger, self->texture_registrar, url, bind_func, token, access_token, client::getParent(),
+                                                context_key ? fl_value_get_string(context_key) : "",
+                                                persist_context && fl_value_get_bool(persist_context),
+                                                std::move(document));
+    FlValue *width = fl_value_lookup_string(args, "width");
+    FlValue *height = fl_value_lookup_string(args, "height");
+    FlValue *device_scale = fl_value_lookup_string(args, "devicePixelRatio");
+    handler->getBridgeForTexture(texture_id)->setInitialSize(
+        width && fl_value_get_type(width) == FL_VALUE_TYPE_INT ? fl_value_get_int(width) : 0,
+        height && fl_value_get_type(height) == FL_VALUE_TYPE_INT ? fl_value_get_int(height) : 0,
+        device_scale && fl_value_get_type(device_scale) == FL_VALUE_TYPE_FLOAT ? fl_value_get_float(device_scale) : 1.0);
+    FlValue *composite_popup = fl_value_lookup_string(args, "compositePopup");
+    if (composite_popup && fl_value_get_type(composite_popup) == FL_VALUE_TYPE_BOOL)
+    {
+      handler->getBridgeForTexture(texture_id)->setPopupCompositing(fl_value_get_bool(composite_popup));
+    }
+    FlValue *event_port = fl_value_lookup_string(args, "eventPort");
+    if (event_port && fl_value_get_type(event_port) == FL_VALUE_TYPE_INT && native_port::IsAvailable())
+    {
+      handler->getBridgeForTexture(texture_id)->setEventPort(fl_value_get_int(event_port));
+    }
+    ALOG(Info, "Create browser request for {} texture", texture_id);
     g_autoptr(FlValue) result = fl_value_new_int(texture_id);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
@@ -200,9 +352,112 @@ static void dart_cef_plugin_handle_method_call(
     handler->CloseAllBrowsers(force);
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
   }
+  else if (strcmp(method, "getResourceUsage") == 0)
+  {
+    g_autoptr(FlValue) result = handler->getResourceUsage();
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  else if (strcmp(method, "setResourceSamplingInterval") == 0)
+  {
+    ResourceMonitor::GetInstance()->SetInterval(fl_value_get_int(args));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "startTracing") == 0)
+  {
+    // empty categories record the chromium defaults, plugin events included
+    std::string categories = fl_value_get_type(args) == FL_VALUE_TYPE_STRING ? fl_value_get_string(args) : "";
+    client::startTracing(FL_METHOD_CALL(g_object_ref(method_call)), categories);
+    TRACE_EVENT_COPY_END0(kTraceCategory, method);
+    return;
+  }
+  else if (strcmp(method, "stopTracing") == 0)
+  {
+    // CEF writes to a file in the home directory when no path is given
+    std::string path = fl_value_get_type(args) == FL_VALUE_TYPE_STRING ? fl_value_get_string(args) : "";
+    client::stopTracing(FL_METHOD_CALL(g_object_ref(method_call)), path);
+    TRACE_EVENT_COPY_END0(kTraceCategory, method);
+    return;
+  }
+  else if (strcmp(method, "dumpEventTrace") == 0)
+  {
+    if (!tracer::kEnabled)
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "tracerDisabled", "plugin was built without DART_CEF_EVENT_TRACER", nullptr));
+    }
+    else
+    {
+      const int written = tracer::Dump(fl_value_get_string(args));
+      g_autoptr(FlValue) result = fl_value_new_int(written);
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    }
+  }
+  else if (strcmp(method, "setEventTraceSpikeDump") == 0)
+  {
+    auto threshold = fl_value_get_int(fl_value_lookup_string(args, "thresholdMs"));
+    auto directory = fl_value_get_string(fl_value_lookup_string(args, "directory"));
+    tracer::SetSpikeDump(threshold, directory);
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "mountAssetPack") == 0)
+  {
+    std::string error;
+    const int count = asset_pack::Mount(fl_value_get_string(args), error);
+    if (count < 0)
+    {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new("invalidAssetPack", error.c_str(), nullptr));
+    }
+    else
+    {
+      g_autoptr(FlValue) result = fl_value_new_int(count);
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    }
+  }
+  else if (strcmp(method, "setCachePath") == 0)
+  {
+    request_contexts::SetDefaultCachePath(fl_value_get_string(args));
+    g_autoptr(FlValue) result = fl_value_new_string(request_contexts::RootCachePath().c_str());
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  else if (strcmp(method, "setResponseCache") == 0)
+  {
+    response_cache::Config config;
+    config.max_bytes = fl_value_get_int(fl_value_lookup_string(args, "maxBytes"));
+    FlValue *prefixes = fl_value_lookup_string(args, "urlPrefixes");
+    for (size_t i = 0; prefixes && i < fl_value_get_length(prefixes); i++)
+    {
+      config.url_prefixes.push_back(fl_value_get_string(fl_value_get_list_value(prefixes, i)));
+    }
+    response_cache::Configure(std::move(config));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "getResponseCacheStats") == 0)
+  {
+    const auto stats = response_cache::GetStats();
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "hits", fl_value_new_int(stats.hits));
+    fl_value_set_string_take(result, "misses", fl_value_new_int(stats.misses));
+    fl_value_set_string_take(result, "coalesced", fl_value_new_int(stats.coalesced));
+    fl_value_set_string_take(result, "evictions", fl_value_new_int(stats.evictions));
+    fl_value_set_string_take(result, "entries", fl_value_new_int(stats.entries));
+    fl_value_set_string_take(result, "bytes", fl_value_new_int(stats.bytes));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  else if (strcmp(method, "setCacheMetricsEnabled") == 0)
+  {
+    cache_metrics::SetEnabled(fl_value_get_bool(args));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
+  else if (strcmp(method, "setLogLevel") == 0)
+  {
+    async_log::SetLevel(async_log::ParseLevel(fl_value_get_string(args), async_log::Level::Info));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
+  }
   else if (strcmp(method, "shutdown") == 0)
   {
+    ResourceMonitor::GetInstance()->Stop();
     CefShutdown();
+    async_log::Shutdown();
     response = FL_METHOD_RESPONSE(fl_method_success_response_new(NULL));
   }
   else
@@ -211,6 +466,7 @@ static void dart_cef_plugin_handle_method_call(
   }
 
   fl_method_call_respond(method_call, response, nullptr);
+  TRACE_EVENT_COPY_END0(kTraceCategory, method);
 }
 
 static void dart_cef_plugin_dispose(GObject *object)
@@ -253,5 +509,5 @@ void dart_cef_plugin_register_with_registrar(FlPluginRegistrar *registrar)
 
   g_object_unref(plugin);
 
-  LOG(INFO) << "Successfully loaded webview_cef plugin" << std::endl;
+  ALOG(Info, "Successfully loaded webview_cef plugin");
 }
@@ -0,0 +1,98 @@
+#include "devtools_client.h"
+
+#include "include/cef_parser.h"
+#include "include/wrapper/cef_helpers.h"
+
+DevToolsClient::DevToolsClient(CefRefPtr<CefBrowser> browser)
+    : browser_(browser)
+{
+  CEF_REQUIRE_UI_THREAD();
+  registration_ = browser_->GetHost()->AddDevToolsMessageObserver(this);
+}
+
+bool DevToolsClient::Execute(const std::string &method,
+                             CefRefPtr<CefDictionaryValue> params,
+                             ResultCallback callback)
+{
+  CEF_REQUIRE_UI_THREAD();
+  if (!browser_ || !registration_)
+  {
+    return false;
+  }
+  // let CEF pick the id, other clients of the same browser see our results
+  const int message_id = browser_->GetHost()->ExecuteDevToolsMethod(0, method, params);
+  if (message_id == 0)
+  {
+    return false;
+  }
+  if (callback)
+  {
+    pending_[message_id] = std::move(callback);
+  }
+  return true;
+}
+
+void DevToolsClient::SetEventCallback(EventCallback callback)
+{
+  CEF_REQUIRE_UI_THREAD();
+  event_callback_ = std::move(callback);
+}
+
+void DevToolsClient::Detach()
+{
+  CEF_REQUIRE_UI_THREAD();
+  pending_.clear();
+  event_callback_ = nullptr;
+  registration_ = nullptr;
+  browser_ = nullptr;
+}
+
+void DevToolsClient::OnDevToolsMethodResult(CefRefPtr<CefBrowser> browser,
+                                            int message_id,
+                                            bool success,
+                                            const void *result,
+                                            size_t result_size)
+{
+  auto it = pending_.find(message_id);
+  if (it == pending_.end())
+  {
+    return;
+  }
+  ResultCallback callback = std::move(it->second);
+  pending_.erase(it);
+
+  CefRefPtr<CefDictionaryValue> dictionary;
+  if (success && result_size > 0)
+  {
+    CefRefPtr<CefValue> value = CefParseJSON(result, result_size, JSON_PARSER_RFC);
+    if (value && value->GetType() == VTYPE_DICTIONARY)
+    {
+      dictionary = value->GetDictionary();
+    }
+  }
+  callback(success && dictionary, dictionary);
+}
+
+void DevToolsClient::OnDevToolsEvent(CefRefPtr<CefBrowser> browser,
+                                     const CefString &method,
+                                     const void *params,
+                                     size_t params_size)
+{
+  if (!event_callback_)
+  {
+    return;
+  }
+  CefRefPtr<CefDictionaryValue> dictionary;
+  if (params_size > 0)
+  {
+    CefRefPtr<CefValue> value = CefParseJSON(params, params_size, JSON_PARSER_RFC);
+    if (value && value->GetType() == VTYPE_DICTIONARY)
+    {
+      dictionary = value->GetDictionary();
+    }
+  }
+  if (dictionary)
+  {
+    event_callback_(method, dictionary);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "include/cef_browser.h"
+#include "include/cef_devtools_message_observer.h"
+#include "include/cef_registration.h"
+#include "include/cef_values.h"
+
+#include <functional>
+#include <map>
+#include <string>
+
+// Thin wrapper around the DevTools protocol of a single browser. Methods are
+// sent with ExecuteDevToolsMethod and results are routed back to the callback
+// registered for the message id. Everything here runs on the CEF UI thread.
+class DevToolsClient : public CefDevToolsMessageObserver
+{
+public:
+  typedef std::function<void(bool success, CefRefPtr<CefDictionaryValue> result)> ResultCallback;
+
+  typedef std::function<void(const std::string &method, CefRefPtr<CefDictionaryValue> params)> EventCallback;
+
+  explicit DevToolsClient(CefRefPtr<CefBrowser> browser);
+
+  // Execute |method| with optional |params|. |callback| receives the parsed
+  // "result" dictionary of the response. Returns false if the method could
+  // not be sent.
+  bool Execute(const std::string &method,
+               CefRefPtr<CefDictionaryValue> params,
+               ResultCallback callback);
+
+  // Receive the events of enabled domains, replaces the previous callback.
+  void SetEventCallback(EventCallback callback);
+
+  // Unregister the observer and drop pending callbacks. Must be called before
+  // the browser goes away, the registration keeps this object alive.
+  void Detach();
+
+  virtual void OnDevToolsMethodResult(CefRefPtr<CefBrowser> browser,
+                                      int message_id,
+                                      bool success,
+                                      const void *result,
+                                      size_t result_size) override;
+
+  virtual void OnDevToolsEvent(CefRefPtr<CefBrowser> browser,
+                               const CefString &method,
+                               const void *params,
+                               size_t params_size) override;
+
+private:
+  CefRefPtr<CefBrowser> browser_;
+
+  CefRefPtr<CefRegistration> registration_;
+
+  // Map of message id -> callback waiting for the result
+  std::map<int, ResultCallback> pending_;
+
+  EventCallback event_callback_;
+
+  IMPLEMENT_REFCOUNTING(DevToolsClient);
+};
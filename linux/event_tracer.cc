@@ -0,0 +1,239 @@
+#include "event_tracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace tracer
+{
+  namespace
+  {
+    const char *const kEventNames[] = {
+        "OnPaint",
+        "SendBuffer",
+        "CopyPixels",
+        "GetViewRect",
+        "OnProcessMessageReceived",
+        "OnAfterCreated",
+        "OnBeforeClose",
+        "OnLoadingStateChange",
+        "OnAddressChange",
+        "OnTitleChange",
+        "OnCursorChange",
+        "OnPopupShow",
+        "OnPopupSize",
+        "MethodCall",
+        "KeyEvent",
+        "MouseMove",
+        "MouseClick",
+        "MouseWheel",
+        "RunTasks",
+        "FrameSpike",
+    };
+    static_assert(sizeof(kEventNames) / sizeof(kEventNames[0]) == static_cast<size_t>(Event::Count),
+                  "every event needs a name");
+    static_assert((kRingSize & (kRingSize - 1)) == 0, "ring size must be a power of two");
+
+    // A record slot, written with relaxed atomics so a dump running alongside
+    // the owner is not a data race. |sequence| is the index + 1 of the record
+    // once complete and 0 while the owner rewrites the slot.
+    struct Slot
+    {
+      std::atomic<uint64_t> sequence{0};
+      std::atomic<uint64_t> timestamp{0};
+      std::atomic<uint64_t> arg{0};
+      std::atomic<Event> event{Event::Count};
+      std::atomic<Phase> phase{Phase::Instant};
+    };
+
+    struct Ring
+    {
+      Slot slots[kRingSize];
+      // number of records ever appended, only written by the owning thread
+      std::atomic<uint64_t> head{0};
+      long thread_id = 0;
+    };
+
+    // Pairs a raw timestamp with steady clock nanoseconds to convert tsc ticks.
+    struct Anchor
+    {
+      uint64_t ticks;
+      int64_t nanos;
+
+      static Anchor Take()
+      {
+        return {Now(), std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count()};
+      }
+    };
+
+    const Anchor g_anchor = Anchor::Take();
+
+    std::mutex g_rings_mutex;
+
+    // Rings are never freed, records of exited threads stay available for dumps
+    std::vector<Ring *> g_rings;
+
+    thread_local Ring *t_ring = nullptr;
+
+    std::atomic<uint64_t> g_spike_threshold_ticks{0};
+    std::atomic<int64_t> g_spike_cooldown_ms{10000};
+    std::atomic<int64_t> g_last_spike_dump_ms{0};
+    std::mutex g_spike_mutex;
+    std::string g_spike_directory;
+
+    Ring *RegisterThread()
+    {
+      Ring *ring = new Ring();
+      ring->thread_id = syscall(SYS_gettid);
+      std::lock_guard<std::mutex> lock(g_rings_mutex);
+      g_rings.push_back(ring);
+      t_ring = ring;
+      return ring;
+    }
+
+    double NanosPerTick()
+    {
+      const Anchor now = Anchor::Take();
+      if (now.ticks <= g_anchor.ticks)
+      {
+        return 1.0;
+      }
+      return static_cast<double>(now.nanos - g_anchor.nanos) / (now.ticks - g_anchor.ticks);
+    }
+
+    int64_t WallClockMs()
+    {
+      return std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+          .count();
+    }
+  }
+
+  void Append(Event event, Phase phase, uint64_t arg)
+  {
+    Ring *ring = t_ring ? t_ring : RegisterThread();
+    const uint64_t index = ring->head.load(std::memory_order_relaxed);
+    Slot &slot = ring->slots[index & (kRingSize - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp.store(Now(), std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.event.store(event, std::memory_order_relaxed);
+    slot.phase.store(phase, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    ring->head.store(index + 1, std::memory_order_release);
+  }
+
+  int Dump(const std::string &path)
+  {
+    std::vector<Ring *> rings;
+    {
+      std::lock_guard<std::mutex> lock(g_rings_mutex);
+      rings = g_rings;
+    }
+
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+      return -1;
+    }
+
+    const double nanos_per_tick = NanosPerTick();
+    const int pid = getpid();
+    std::unique_ptr<Record[]> copy(new Record[kRingSize]);
+    int written = 0;
+
+    fputs("{\"traceEvents\":[", file);
+    for (Ring *ring : rings)
+    {
+      const uint64_t head = ring->head.load(std::memory_order_acquire);
+      const uint64_t count = head < kRingSize ? head : kRingSize;
+      uint64_t copied = 0;
+      for (uint64_t i = head - count; i < head; i++)
+      {
+        // seqlock read, the owner may reuse the slot while we copy it
+        const Slot &slot = ring->slots[i & (kRingSize - 1)];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        Record &record = copy[copied];
+        record.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        record.arg = slot.arg.load(std::memory_order_relaxed);
+        record.event = slot.event.load(std::memory_order_relaxed);
+        record.phase = slot.phase.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence == i + 1 && slot.sequence.load(std::memory_order_relaxed) == i + 1)
+        {
+          copied++;
+        }
+      }
+
+      for (uint64_t i = 0; i < copied; i++)
+      {
+        const Record &record = copy[i];
+        const double ts_us =
+            (static_cast<int64_t>(record.timestamp - g_anchor.ticks) * nanos_per_tick + g_anchor.nanos) / 1000.0;
+        const char phase = record.phase == Phase::Begin ? 'B' : record.phase == Phase::End ? 'E'
+                                                                                           : 'i';
+        fprintf(file,
+                "%s{\"name\":\"%s\",\"cat\":\"dart_cef\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld%s,\"args\":{\"arg\":%llu}}",
+                written ? "," : "",
+                kEventNames[static_cast<size_t>(record.event)],
+                phase,
+                ts_us,
+                pid,
+                ring->thread_id,
+                record.phase == Phase::Instant ? ",\"s\":\"t\"" : "",
+                static_cast<unsigned long long>(record.arg));
+        written++;
+      }
+    }
+    fputs("]}\n", file);
+    fclose(file);
+    return written;
+  }
+
+  void SetSpikeDump(int threshold_ms, const std::string &directory, int cooldown_ms)
+  {
+    {
+      std::lock_guard<std::mutex> lock(g_spike_mutex);
+      g_spike_directory = directory;
+    }
+    g_spike_cooldown_ms = cooldown_ms;
+    g_spike_threshold_ticks = threshold_ms > 0 ? static_cast<uint64_t>(threshold_ms * 1000000.0 / NanosPerTick()) : 0;
+  }
+
+  void ReportFrameTime(uint64_t begin, uint64_t end)
+  {
+    const uint64_t threshold = g_spike_threshold_ticks.load(std::memory_order_relaxed);
+    if (threshold == 0 || end - begin < threshold)
+    {
+      return;
+    }
+    Append(Event::FrameSpike, Phase::Instant, end - begin);
+
+    const int64_t now = WallClockMs();
+    int64_t last = g_last_spike_dump_ms.load();
+    if (now - last < g_spike_cooldown_ms || !g_last_spike_dump_ms.compare_exchange_strong(last, now))
+    {
+      return;
+    }
+
+    std::string path;
+    {
+      std::lock_guard<std::mutex> lock(g_spike_mutex);
+      path = g_spike_directory + "/dart_cef_spike_" + std::to_string(now) + ".json";
+    }
+    // never block the frame path on file io
+    std::thread([path]
+                { Dump(path); })
+        .detach();
+  }
+}
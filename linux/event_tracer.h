@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Always-on tracer for the plugin's hot paths. Every thread appends fixed-size
+// records to its own ring buffer, so recording is a timestamp read and a few
+// stores without locks or allocations. Rings are only read when dumped, which
+// writes a chrome json trace of the most recent records of all threads.
+//
+// Compiled in with DART_CEF_EVENT_TRACER, otherwise the macros are no-ops.
+namespace tracer
+{
+  enum class Event : uint16_t
+  {
+    OnPaint,
+    SendBuffer,
+    CopyPixels,
+    GetViewRect,
+    OnProcessMessageReceived,
+    OnAfterCreated,
+    OnBeforeClose,
+    OnLoadingStateChange,
+    OnAddressChange,
+    OnTitleChange,
+    OnCursorChange,
+    OnPopupShow,
+    OnPopupSize,
+    MethodCall,
+    KeyEvent,
+    MouseMove,
+    MouseClick,
+    MouseWheel,
+    RunTasks,
+    FrameSpike,
+    Count
+  };
+
+  enum class Phase : uint8_t
+  {
+    Begin,
+    End,
+    Instant
+  };
+
+  struct Record
+  {
+    uint64_t timestamp;
+    uint64_t arg;
+    Event event;
+    Phase phase;
+  };
+
+#ifdef DART_CEF_EVENT_TRACER
+  constexpr bool kEnabled = true;
+#else
+  constexpr bool kEnabled = false;
+#endif
+
+  // records kept per thread, must be a power of two
+  constexpr uint32_t kRingSize = 8192;
+
+  inline uint64_t Now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+
+  void Append(Event event, Phase phase, uint64_t arg);
+
+  // Writes the content of all rings as a chrome json trace to |path|.
+  // Returns the number of records written or -1 if the file can't be opened.
+  int Dump(const std::string &path);
+
+  // Dump into |directory| when a frame takes longer than |threshold_ms|,
+  // at most once per |cooldown_ms|. A threshold of 0 disables spike dumps.
+  void SetSpikeDump(int threshold_ms, const std::string &directory, int cooldown_ms = 10000);
+
+  // Report the duration of a frame, dumps in the background on a spike.
+  void ReportFrameTime(uint64_t begin, uint64_t end);
+
+  class ScopedEvent
+  {
+  public:
+    explicit ScopedEvent(Event event, uint64_t arg = 0) : event_(event)
+    {
+      Append(event_, Phase::Begin, arg);
+    }
+    ~ScopedEvent()
+    {
+      Append(event_, Phase::End, 0);
+    }
+
+  private:
+    Event event_;
+  };
+}
+
+#define EVENT_TRACE_CONCAT_INNER(a, b) a##b
+#define EVENT_TRACE_CONCAT(a, b) EVENT_TRACE_CONCAT_INNER(a, b)
+
+#ifdef DART_CEF_EVENT_TRACER
+#define EVENT_TRACE_SCOPE(event) \
+  tracer::ScopedEvent EVENT_TRACE_CONCAT(event_trace_, __LINE__)(tracer::Event::event)
+#define EVENT_TRACE_SCOPE1(event, arg) \
+  tracer::ScopedEvent EVENT_TRACE_CONCAT(event_trace_, __LINE__)(tracer::Event::event, static_cast<uint64_t>(arg))
+#define EVENT_TRACE_INSTANT(event, arg) \
+  tracer::Append(tracer::Event::event, tracer::Phase::Instant, static_cast<uint64_t>(arg))
+#define EVENT_TRACE_NOW() tracer::Now()
+#define EVENT_TRACE_FRAME(begin) tracer::ReportFrameTime(begin, tracer::Now())
+#else
+#define EVENT_TRACE_SCOPE(event) ((void)0)
+#define EVENT_TRACE_SCOPE1(event, arg) ((void)0)
+#define EVENT_TRACE_INSTANT(event, arg) ((void)0)
+#define EVENT_TRACE_NOW() uint64_t(0)
+#define EVENT_TRACE_FRAME(begin) ((void)(begin))
+#endif
@@ -2,6 +2,7 @@
 #define FLUTTER_PLUGIN_DART_CEF_PLUGIN_H_
 
 #include <flutter_linux/flutter_linux.h>
+#include <stdint.h>
 
 G_BEGIN_DECLS
 
@@ -32,6 +33,90 @@ FLUTTER_PLUGIN_EXPORT void setParentWindow(GtkWidget* parent);
 
 FLUTTER_PLUGIN_EXPORT bool sendKeyEvent(GdkEventKey *event);
 
+// Input entry points for dart:ffi, see lib/src/input_ffi.dart. Coordinates
+// are relative to the webview, buttons and modifiers use the CEF values.
+// Safe to call from any thread, events are delivered in order.
+#define DART_CEF_INPUT_VERSION 2
+
+FLUTTER_PLUGIN_EXPORT int32_t dart_cef_input_version();
+
+FLUTTER_PLUGIN_EXPORT void dart_cef_input_move(int64_t texture_id, int32_t x, int32_t y, uint32_t modifiers);
+
+FLUTTER_PLUGIN_EXPORT void dart_cef_input_click(int64_t texture_id, int32_t x, int32_t y, int32_t button,
+                                                int32_t up, int32_t click_count, uint32_t modifiers);
+
+FLUTTER_PLUGIN_EXPORT void dart_cef_input_wheel(int64_t texture_id, int32_t x, int32_t y, int32_t delta_x,
+                                                int32_t delta_y, uint32_t modifiers);
+
+typedef struct
+{
+  int64_t events;
+  // delay between the call and the delivery to the browser
+  int64_t total_ns;
+  int64_t max_ns;
+} DartCefInputLatency;
+
+// Returns the latency counters of delivered events, clears them if |reset|
+// is set.
+FLUTTER_PLUGIN_EXPORT DartCefInputLatency dart_cef_input_latency(int32_t reset);
+
+typedef enum
+{
+  DART_CEF_INPUT_MOVE = 0,
+  // a: button, b: click count, up in the lowest bit of |flags|
+  DART_CEF_INPUT_CLICK = 1,
+  // a, b: deltas
+  DART_CEF_INPUT_WHEEL = 2,
+} DartCefInputType;
+
+typedef struct
+{
+  uint32_t type;
+  uint32_t modifiers;
+  int32_t x;
+  int32_t y;
+  int32_t a;
+  int32_t b;
+  uint32_t flags;
+  uint32_t reserved;
+  // wall clock microseconds when the event happened
+  int64_t timestamp_us;
+} DartCefInputRecord;
+
+// Single-producer single-consumer ring of input records in native memory
+// that Dart writes directly. The producer fills records[head % capacity],
+// then publishes the new head with dart_cef_input_ring_commit. The CEF UI
+// thread drains everything up to head and advances tail, consecutive moves
+// are merged into the last one.
+typedef struct
+{
+  uint32_t capacity;
+  uint32_t reserved;
+  DartCefInputRecord *records;
+  uint8_t padding0[48];
+  // written by the producer only
+  uint64_t head;
+  uint8_t padding1[56];
+  // written by the consumer only
+  uint64_t tail;
+  uint8_t padding2[56];
+} DartCefInputRing;
+
+// Returns the ring of |texture_id|, created with |capacity| records rounded
+// up to a power of two on first use.
+FLUTTER_PLUGIN_EXPORT DartCefInputRing *dart_cef_input_ring_create(int64_t texture_id, uint32_t capacity);
+
+// Publishes the records before |head| and wakes the consumer unless a drain
+// is already pending.
+FLUTTER_PLUGIN_EXPORT void dart_cef_input_ring_commit(DartCefInputRing *ring, uint64_t head);
+
+// Drops the ring, the producer must not touch it afterwards.
+FLUTTER_PLUGIN_EXPORT void dart_cef_input_ring_destroy(DartCefInputRing *ring);
+
+// Enables event delivery to Dart ports, |post_cobject| is
+// NativeApi.postCObject. See lib/src/native_port.dart.
+FLUTTER_PLUGIN_EXPORT void dart_cef_native_port_init(void *post_cobject);
+
 G_END_DECLS
 
 #endif // FLUTTER_PLUGIN_DART_CEF_PLUGIN_H_
@@ -0,0 +1,153 @@
+#include "inline_content.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include "include/cef_resource_handler.h"
+
+#include "webview.h"
+
+namespace inline_content
+{
+  namespace
+  {
+    std::mutex g_mutex;
+
+    // Map of document id -> document, entries expire with their last owner
+    std::map<uint64_t, std::weak_ptr<const Document>> g_documents;
+
+    std::atomic<uint64_t> g_next_id{1};
+
+    DocumentRef Find(const std::string &url)
+    {
+      const std::string prefix = std::string(kAppScheme) + "://" + kHost + "/";
+      if (url.compare(0, prefix.size(), prefix) != 0)
+      {
+        return nullptr;
+      }
+      uint64_t id = 0;
+      try
+      {
+        id = std::stoull(url.substr(prefix.size()));
+      }
+      catch (const std::exception &)
+      {
+        return nullptr;
+      }
+      std::lock_guard<std::mutex> lock(g_mutex);
+      auto it = g_documents.find(id);
+      if (it == g_documents.end())
+      {
+        return nullptr;
+      }
+      DocumentRef document = it->second.lock();
+      if (!document)
+      {
+        g_documents.erase(it);
+      }
+      return document;
+    }
+
+    // Copies the document into the buffers the network service hands us, at
+    // most |bytes_to_read| per call.
+    class InlineResourceHandler : public CefResourceHandler
+    {
+    public:
+      explicit InlineResourceHandler(DocumentRef document) : document_(std::move(document)) {}
+
+      bool Open(CefRefPtr<CefRequest> request,
+                bool &handle_request,
+                CefRefPtr<CefCallback> callback) override
+      {
+        handle_request = true;
+        return true;
+      }
+
+      void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                              int64 &response_length,
+                              CefString &redirectUrl) override
+      {
+        response->SetStatus(200);
+        response->SetStatusText("OK");
+        response->SetMimeType(document_->mime_type);
+        response->SetCharset("utf-8");
+        response_length = document_->data.size();
+      }
+
+      bool Read(void *data_out,
+                int bytes_to_read,
+                int &bytes_read,
+                CefRefPtr<CefResourceReadCallback> callback) override
+      {
+        const size_t remaining = document_->data.size() - offset_;
+        if (remaining == 0)
+        {
+          bytes_read = 0;
+          return false;
+        }
+        const size_t count = std::min(remaining, static_cast<size_t>(bytes_to_read));
+        memcpy(data_out, document_->data.data() + offset_, count);
+        offset_ += count;
+        bytes_read = static_cast<int>(count);
+        return true;
+      }
+
+      void Cancel() override {}
+
+    private:
+      DocumentRef document_;
+      size_t offset_ = 0;
+
+      IMPLEMENT_REFCOUNTING(InlineResourceHandler);
+      DISALLOW_COPY_AND_ASSIGN(InlineResourceHandler);
+    };
+
+    class InlineSchemeHandlerFactory : public CefSchemeHandlerFactory
+    {
+    public:
+      CefRefPtr<CefResourceHandler> Create(CefRefPtr<CefBrowser> browser,
+                                           CefRefPtr<CefFrame> frame,
+                                           const CefString &scheme_name,
+                                           CefRefPtr<CefRequest> request) override
+      {
+        DocumentRef document = Find(request->GetURL().ToString());
+        if (!document)
+        {
+          // falls through to a 404
+          return nullptr;
+        }
+        return new InlineResourceHandler(std::move(document));
+      }
+
+    private:
+      IMPLEMENT_REFCOUNTING(InlineSchemeHandlerFactory);
+    };
+  }
+
+  DocumentRef Add(std::string data, const std::string &mime_type)
+  {
+    const uint64_t id = g_next_id++;
+    auto document = std::make_shared<const Document>(Document{
+        std::string(kAppScheme) + "://" + kHost + "/" + std::to_string(id),
+        mime_type,
+        std::move(data)});
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    // drop entries whose owners are gone
+    for (auto it = g_documents.begin(); it != g_documents.end();)
+    {
+      it = it->second.expired() ? g_documents.erase(it) : std::next(it);
+    }
+    g_documents[id] = document;
+    return document;
+  }
+
+  CefRefPtr<CefSchemeHandlerFactory> CreateSchemeHandlerFactory()
+  {
+    return new InlineSchemeHandlerFactory();
+  }
+}
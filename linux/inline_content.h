@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "include/cef_scheme.h"
+
+// Serves documents handed over by Dart (loadHTML, createBrowser with isHTML)
+// from memory under dartcef://inline/<id>, instead of encoding them into a
+// data: URI. A document lives as long as someone holds its reference, the
+// bridge keeps the one it shows so reloads keep working, and a request that
+// is being served keeps its own.
+namespace inline_content
+{
+  constexpr auto kHost = "inline";
+
+  struct Document
+  {
+    std::string url;
+    std::string mime_type;
+    std::string data;
+  };
+
+  typedef std::shared_ptr<const Document> DocumentRef;
+
+  // Stores |data| and returns the document with the url it is served at.
+  DocumentRef Add(std::string data, const std::string &mime_type);
+
+  // Returns a new factory for CefRegisterSchemeHandlerFactory.
+  CefRefPtr<CefSchemeHandlerFactory> CreateSchemeHandlerFactory();
+}
@@ -0,0 +1,253 @@
+#include "include/dart_cef/dart_cef_plugin.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
+#include "include/wrapper/cef_helpers.h"
+
+#include "event_tracer.h"
+#include "simple_handler.h"
+
+// Input entry points for dart:ffi. They are called on the Dart UI thread and
+// only post a task, the event reaches the browser on the CEF UI thread
+// without the codec, the platform thread hop and the method lookup of the
+// method channel. The ring variant lets Dart write events into shared memory
+// and wakes the UI thread once per batch instead of once per event.
+namespace
+{
+  // ring capacity bounds, in records
+  constexpr uint32_t kMinRingCapacity = 64;
+  constexpr uint32_t kMaxRingCapacity = 65536;
+
+  std::atomic<uint64_t> g_events{0};
+  std::atomic<uint64_t> g_latency_total_ns{0};
+  std::atomic<uint64_t> g_latency_max_ns{0};
+
+  int64_t NowMicros()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void RecordLatency(int64_t timestamp_us)
+  {
+    const uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(NowMicros() - timestamp_us, 0)) * 1000;
+    g_events.fetch_add(1, std::memory_order_relaxed);
+    g_latency_total_ns.fetch_add(latency, std::memory_order_relaxed);
+    uint64_t max = g_latency_max_ns.load(std::memory_order_relaxed);
+    while (latency > max && !g_latency_max_ns.compare_exchange_weak(max, latency, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  CefRefPtr<CefBrowserHost> GetHost(int64_t texture_id)
+  {
+    SimpleHandler *handler = SimpleHandler::GetInstance();
+    CefRefPtr<BrowserBridge> bridge = handler ? handler->getBridgeForTexture(texture_id) : nullptr;
+    if (!bridge || !bridge->browser_ || bridge->closing)
+    {
+      return nullptr;
+    }
+    return bridge->browser_->GetHost();
+  }
+
+  void Send(CefRefPtr<CefBrowserHost> host, const DartCefInputRecord &record)
+  {
+    CefMouseEvent mouse;
+    mouse.x = record.x;
+    mouse.y = record.y;
+    mouse.modifiers = record.modifiers;
+    switch (record.type)
+    {
+    case DART_CEF_INPUT_MOVE:
+    {
+      EVENT_TRACE_SCOPE(MouseMove);
+      host->SendMouseMoveEvent(mouse, false);
+      break;
+    }
+    case DART_CEF_INPUT_CLICK:
+    {
+      const bool up = (record.flags & 1) != 0;
+      EVENT_TRACE_SCOPE1(MouseClick, up);
+      host->SetFocus(true);
+      host->SendMouseClickEvent(mouse, static_cast<CefBrowserHost::MouseButtonType>(record.a), up, record.b);
+      break;
+    }
+    case DART_CEF_INPUT_WHEEL:
+    {
+      EVENT_TRACE_SCOPE1(MouseWheel, record.b);
+      host->SendMouseWheelEvent(mouse, record.a, record.b);
+      break;
+    }
+    default:
+      return;
+    }
+    RecordLatency(record.timestamp_us);
+  }
+
+  void Dispatch(int64_t texture_id, DartCefInputRecord record)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    CefRefPtr<CefBrowserHost> host = GetHost(texture_id);
+    if (host)
+    {
+      Send(host, record);
+    }
+  }
+
+  void Post(int64_t texture_id, DartCefInputRecord record)
+  {
+    record.timestamp_us = NowMicros();
+    CefPostTask(TID_UI, base::BindOnce(&Dispatch, texture_id, record));
+  }
+
+  struct Ring
+  {
+    int64_t texture_id = 0;
+    std::unique_ptr<DartCefInputRecord[]> records;
+    DartCefInputRing header = {};
+    // set by the producer when it posts a drain, cleared by the drain
+    std::atomic<bool> drain_pending{false};
+  };
+
+  std::mutex g_rings_mutex;
+
+  // Map of ring header -> ring, the drain task keeps its ring alive
+  std::map<DartCefInputRing *, std::shared_ptr<Ring>> g_rings;
+
+  std::shared_ptr<Ring> FindRing(DartCefInputRing *header)
+  {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    auto it = g_rings.find(header);
+    return it == g_rings.end() ? nullptr : it->second;
+  }
+
+  bool IsMergeableMove(const DartCefInputRecord &record, const DartCefInputRecord &next)
+  {
+    return record.type == DART_CEF_INPUT_MOVE && next.type == DART_CEF_INPUT_MOVE &&
+           record.modifiers == next.modifiers;
+  }
+
+  void Drain(std::shared_ptr<Ring> ring)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    // cleared before reading head so a commit racing with the drain posts
+    // another one instead of being missed
+    ring->drain_pending.store(false, std::memory_order_seq_cst);
+
+    // the header lives in memory Dart writes to, plain fields accessed with
+    // the gcc atomic builtins
+    const uint64_t head = __atomic_load_n(&ring->header.head, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->header.tail;
+    if (tail == head)
+    {
+      return;
+    }
+
+    const uint64_t mask = ring->header.capacity - 1;
+    CefRefPtr<CefBrowserHost> host = GetHost(ring->texture_id);
+    for (; tail != head; tail++)
+    {
+      const DartCefInputRecord &record = ring->records[tail & mask];
+      if (!host)
+      {
+        continue;
+      }
+      if (tail + 1 != head && IsMergeableMove(record, ring->records[(tail + 1) & mask]))
+      {
+        // the page only needs the latest pointer position
+        continue;
+      }
+      Send(host, record);
+    }
+    __atomic_store_n(&ring->header.tail, tail, __ATOMIC_RELEASE);
+  }
+
+  uint32_t RoundCapacity(uint32_t capacity)
+  {
+    capacity = std::clamp(capacity, kMinRingCapacity, kMaxRingCapacity);
+    uint32_t rounded = kMinRingCapacity;
+    while (rounded < capacity)
+    {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+}
+
+int32_t dart_cef_input_version()
+{
+  return DART_CEF_INPUT_VERSION;
+}
+
+void dart_cef_input_move(int64_t texture_id, int32_t x, int32_t y, uint32_t modifiers)
+{
+  Post(texture_id, {DART_CEF_INPUT_MOVE, modifiers, x, y, 0, 0, 0, 0, 0});
+}
+
+void dart_cef_input_click(int64_t texture_id, int32_t x, int32_t y, int32_t button, int32_t up,
+                          int32_t click_count, uint32_t modifiers)
+{
+  Post(texture_id, {DART_CEF_INPUT_CLICK, modifiers, x, y, button, click_count, up ? 1u : 0u, 0, 0});
+}
+
+void dart_cef_input_wheel(int64_t texture_id, int32_t x, int32_t y, int32_t delta_x, int32_t delta_y,
+                          uint32_t modifiers)
+{
+  Post(texture_id, {DART_CEF_INPUT_WHEEL, modifiers, x, y, delta_x, delta_y, 0, 0, 0});
+}
+
+DartCefInputLatency dart_cef_input_latency(int32_t reset)
+{
+  DartCefInputLatency latency;
+  latency.events = reset ? g_events.exchange(0) : g_events.load();
+  latency.total_ns = reset ? g_latency_total_ns.exchange(0) : g_latency_total_ns.load();
+  latency.max_ns = reset ? g_latency_max_ns.exchange(0) : g_latency_max_ns.load();
+  return latency;
+}
+
+DartCefInputRing *dart_cef_input_ring_create(int64_t texture_id, uint32_t capacity)
+{
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  for (const auto &[header, ring] : g_rings)
+  {
+    if (ring->texture_id == texture_id)
+    {
+      return header;
+    }
+  }
+  auto ring = std::make_shared<Ring>();
+  ring->texture_id = texture_id;
+  ring->header.capacity = RoundCapacity(capacity);
+  ring->records.reset(new DartCefInputRecord[ring->header.capacity]());
+  ring->header.records = ring->records.get();
+  g_rings[&ring->header] = ring;
+  return &ring->header;
+}
+
+void dart_cef_input_ring_commit(DartCefInputRing *header, uint64_t head)
+{
+  std::shared_ptr<Ring> ring = FindRing(header);
+  if (!ring)
+  {
+    return;
+  }
+  __atomic_store_n(&ring->header.head, head, __ATOMIC_RELEASE);
+  if (!ring->drain_pending.exchange(true, std::memory_order_seq_cst))
+  {
+    CefPostTask(TID_UI, base::BindOnce(&Drain, ring));
+  }
+}
+
+void dart_cef_input_ring_destroy(DartCefInputRing *header)
+{
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  g_rings.erase(header);
+}
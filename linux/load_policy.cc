@@ -0,0 +1,211 @@
+#include "load_policy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
+
+namespace load_policy
+{
+  namespace
+  {
+    // Passes the body through until it grows beyond |limit|, then fails the
+    // request.
+    class SizeLimitFilter : public CefResponseFilter
+    {
+    public:
+      explicit SizeLimitFilter(int64_t limit) : limit_(limit) {}
+
+      bool InitFilter() override { return true; }
+
+      FilterStatus Filter(void *data_in,
+                          size_t data_in_size,
+                          size_t &data_in_read,
+                          void *data_out,
+                          size_t data_out_size,
+                          size_t &data_out_written) override
+      {
+        if (!data_in)
+        {
+          data_in_read = 0;
+          data_out_written = 0;
+          return RESPONSE_FILTER_DONE;
+        }
+        const size_t count = std::min(data_in_size, data_out_size);
+        total_ += count;
+        if (total_ > limit_)
+        {
+          return RESPONSE_FILTER_ERROR;
+        }
+        memcpy(data_out, data_in, count);
+        data_in_read = count;
+        data_out_written = count;
+        return RESPONSE_FILTER_NEED_MORE_DATA;
+      }
+
+    private:
+      const int64_t limit_;
+      int64_t total_ = 0;
+
+      IMPLEMENT_REFCOUNTING(SizeLimitFilter);
+    };
+
+    Action ActionFor(const Policy &policy, cef_resource_type_t type, bool third_party)
+    {
+      switch (type)
+      {
+      case RT_IMAGE:
+        return policy.images;
+      case RT_FONT_RESOURCE:
+        return policy.fonts;
+      case RT_MEDIA:
+        return policy.media;
+      case RT_SCRIPT:
+        return third_party ? policy.third_party_scripts : Action::Allow;
+      default:
+        return Action::Allow;
+      }
+    }
+  }
+
+  // static
+  Registry *Registry::GetInstance()
+  {
+    static Registry instance;
+    return &instance;
+  }
+
+  void Registry::SetPolicy(int browser_id, const Policy &policy)
+  {
+    std::vector<Deferred> released;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto &entry = entries_[browser_id];
+      entry.policy = policy;
+      released.swap(entry.deferred);
+      if (policy.IsDefault())
+      {
+        entries_.erase(browser_id);
+      }
+    }
+    for (auto &deferred : released)
+    {
+      deferred.callback->Continue();
+    }
+  }
+
+  void Registry::Remove(int browser_id)
+  {
+    std::vector<Deferred> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(browser_id);
+      if (it == entries_.end())
+      {
+        return;
+      }
+      cancelled.swap(it->second.deferred);
+      entries_.erase(it);
+    }
+    for (auto &deferred : cancelled)
+    {
+      deferred.callback->Cancel();
+    }
+  }
+
+  void Registry::Copy(int from_browser_id, int to_browser_id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(from_browser_id);
+    if (it != entries_.end())
+    {
+      entries_[to_browser_id].policy = it->second.policy;
+    }
+  }
+
+  cef_return_value_t Registry::OnBeforeResourceLoad(int browser_id,
+                                                    CefRefPtr<CefRequest> request,
+                                                    bool third_party,
+                                                    CefRefPtr<CefCallback> callback)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it == entries_.end())
+    {
+      return RV_CONTINUE;
+    }
+    const Policy &policy = it->second.policy;
+    switch (ActionFor(policy, request->GetResourceType(), third_party))
+    {
+    case Action::Cancel:
+      return RV_CANCEL;
+    case Action::Defer:
+      it->second.deferred.push_back(
+          {callback, std::chrono::steady_clock::now() + std::chrono::milliseconds(policy.defer_ms)});
+      CefPostDelayedTask(TID_IO, base::BindOnce(&Registry::ReleaseDue, base::Unretained(this), browser_id),
+                         policy.defer_ms);
+      return RV_CONTINUE_ASYNC;
+    default:
+      return RV_CONTINUE;
+    }
+  }
+
+  void Registry::ReleaseDue(int browser_id)
+  {
+    std::vector<Deferred> due;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(browser_id);
+      if (it == entries_.end())
+      {
+        return;
+      }
+      auto &deferred = it->second.deferred;
+      const auto now = std::chrono::steady_clock::now();
+      auto split = std::stable_partition(deferred.begin(), deferred.end(),
+                                         [now](const Deferred &item)
+                                         { return item.release_at > now; });
+      std::move(split, deferred.end(), std::back_inserter(due));
+      deferred.erase(split, deferred.end());
+    }
+    for (auto &item : due)
+    {
+      item.callback->Continue();
+    }
+  }
+
+  CefRefPtr<CefResponseFilter> Registry::GetResponseFilter(int browser_id,
+                                                           CefRefPtr<CefRequest> request,
+                                                           CefRefPtr<CefResponse> response)
+  {
+    if (request->GetResourceType() != RT_IMAGE)
+    {
+      return nullptr;
+    }
+    int64_t limit = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(browser_id);
+      if (it == entries_.end())
+      {
+        return nullptr;
+      }
+      limit = it->second.policy.max_image_bytes;
+    }
+    if (limit <= 0)
+    {
+      return nullptr;
+    }
+    // a Content-Length above the limit fails on the first chunk, the filter
+    // still guards responses without one
+    const std::string length = response->GetHeaderByName("Content-Length");
+    if (!length.empty() && std::strtoll(length.c_str(), nullptr, 10) > limit)
+    {
+      return new SizeLimitFilter(0);
+    }
+    return new SizeLimitFilter(limit);
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "include/cef_callback.h"
+#include "include/cef_request.h"
+#include "include/cef_resource_request_handler.h"
+#include "include/cef_response_filter.h"
+
+// Per-browser policy that trades fidelity for cpu by holding back or
+// dropping whole resource categories, e.g. for a "lite" mode on weak kiosk
+// hardware. Enforced by ResourceRequestHandler on the IO thread, Dart can
+// replace a browser's policy at any time.
+namespace load_policy
+{
+  enum class Action
+  {
+    Allow,
+    // start the request once the deferral delay after its creation passed
+    Defer,
+    Cancel,
+  };
+
+  struct Policy
+  {
+    Action images = Action::Allow;
+    Action fonts = Action::Allow;
+    Action media = Action::Allow;
+    Action third_party_scripts = Action::Allow;
+    // images with a larger response are aborted, 0 disables the limit
+    int64_t max_image_bytes = 0;
+    int defer_ms = 2000;
+
+    bool IsDefault() const
+    {
+      return images == Action::Allow && fonts == Action::Allow && media == Action::Allow &&
+             third_party_scripts == Action::Allow && max_image_bytes == 0;
+    }
+  };
+
+  class Registry
+  {
+  public:
+    static Registry *GetInstance();
+
+    // Replaces the policy of |browser_id|, requests deferred under the old
+    // policy are released.
+    void SetPolicy(int browser_id, const Policy &policy);
+
+    // Cancels deferred requests and forgets the browser.
+    void Remove(int browser_id);
+
+    // Gives |to_browser_id| the policy of |from_browser_id|.
+    void Copy(int from_browser_id, int to_browser_id);
+
+    cef_return_value_t OnBeforeResourceLoad(int browser_id,
+                                            CefRefPtr<CefRequest> request,
+                                            bool third_party,
+                                            CefRefPtr<CefCallback> callback);
+
+    // Returns a filter aborting oversized images or nullptr.
+    CefRefPtr<CefResponseFilter> GetResponseFilter(int browser_id,
+                                                   CefRefPtr<CefRequest> request,
+                                                   CefRefPtr<CefResponse> response);
+
+  private:
+    Registry() = default;
+
+    struct Deferred
+    {
+      CefRefPtr<CefCallback> callback;
+      std::chrono::steady_clock::time_point release_at;
+    };
+
+    struct Entry
+    {
+      Policy policy;
+      std::vector<Deferred> deferred;
+    };
+
+    // Continues the deferred requests of |browser_id| that are due.
+    void ReleaseDue(int browser_id);
+
+    std::mutex mutex_;
+
+    // Map of browser id -> policy and requests waiting for it
+    std::map<int, Entry> entries_;
+  };
+}
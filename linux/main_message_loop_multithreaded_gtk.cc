@@ -9,7 +9,10 @@
 
 #include "include/base/cef_callback.h"
 #include "include/base/cef_logging.h"
+#include "include/base/cef_trace_event.h"
 #include "include/wrapper/cef_closure_task.h"
+#include "event_tracer.h"
+#include "webview.h"
 
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 
@@ -137,6 +140,13 @@ void MainMessageLoopMultithreadedGtk::RunTasks() {
     tasks.swap(queued_tasks_);
   }
 
+  if (tasks.empty())
+    return;
+
+  TRACE_EVENT1(kTraceCategory, "MainMessageLoopMultithreadedGtk::RunTasks",
+               "tasks", tasks.size());
+  EVENT_TRACE_SCOPE1(RunTasks, tasks.size());
+
   // Execute all queued tasks.
   while (!tasks.empty()) {
     CefRefPtr<CefTask> task = tasks.front();
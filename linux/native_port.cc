@@ -0,0 +1,184 @@
+#include "native_port.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "include/dart_cef/dart_cef_plugin.h"
+
+namespace
+{
+  // Mirrors the Dart_CObject ABI of dart_native_api.h for the types used here.
+  enum CObjectType : int32_t
+  {
+    kNull = 0,
+    kBool = 1,
+    kInt32 = 2,
+    kInt64 = 3,
+    kDouble = 4,
+    kString = 5,
+    kArray = 6,
+    kTypedData = 7,
+  };
+
+  enum TypedDataType : int32_t
+  {
+    kTypedUint8 = 2,
+    kTypedInt32 = 6,
+    kTypedInt64 = 8,
+    kTypedFloat64 = 11,
+  };
+
+  struct CObject
+  {
+    CObjectType type;
+    union
+    {
+      bool as_bool;
+      int32_t as_int32;
+      int64_t as_int64;
+      double as_double;
+      const char *as_string;
+      struct
+      {
+        intptr_t length;
+        CObject **values;
+      } as_array;
+      struct
+      {
+        TypedDataType type;
+        intptr_t length;
+        const void *values;
+      } as_typed_data;
+      // keeps the union as large as the largest Dart_CObject member
+      intptr_t padding[5];
+    } value;
+  };
+
+  typedef bool (*PostCObjectFunc)(int64_t port, CObject *message);
+
+  std::atomic<PostCObjectFunc> g_post{nullptr};
+
+  // Owns the objects of one message until it is posted, Dart_PostCObject
+  // copies everything including strings and typed data.
+  class Encoder
+  {
+  public:
+    CObject *Encode(FlValue *value)
+    {
+      CObject *object = &objects_.emplace_back();
+      object->type = kNull;
+      switch (fl_value_get_type(value))
+      {
+      case FL_VALUE_TYPE_BOOL:
+        object->type = kBool;
+        object->value.as_bool = fl_value_get_bool(value);
+        break;
+      case FL_VALUE_TYPE_INT:
+        object->type = kInt64;
+        object->value.as_int64 = fl_value_get_int(value);
+        break;
+      case FL_VALUE_TYPE_FLOAT:
+        object->type = kDouble;
+        object->value.as_double = fl_value_get_float(value);
+        break;
+      case FL_VALUE_TYPE_STRING:
+        object->type = kString;
+        object->value.as_string = fl_value_get_string(value);
+        break;
+      case FL_VALUE_TYPE_UINT8_LIST:
+        SetTypedData(object, kTypedUint8, fl_value_get_uint8_list(value), fl_value_get_length(value));
+        break;
+      case FL_VALUE_TYPE_INT32_LIST:
+        SetTypedData(object, kTypedInt32, fl_value_get_int32_list(value), fl_value_get_length(value));
+        break;
+      case FL_VALUE_TYPE_INT64_LIST:
+        SetTypedData(object, kTypedInt64, fl_value_get_int64_list(value), fl_value_get_length(value));
+        break;
+      case FL_VALUE_TYPE_FLOAT_LIST:
+        SetTypedData(object, kTypedFloat64, fl_value_get_float_list(value), fl_value_get_length(value));
+        break;
+      case FL_VALUE_TYPE_LIST:
+      {
+        const size_t length = fl_value_get_length(value);
+        CObject **values = NewArray(object, length);
+        for (size_t i = 0; i < length; i++)
+        {
+          values[i] = Encode(fl_value_get_list_value(value, i));
+        }
+        break;
+      }
+      case FL_VALUE_TYPE_MAP:
+      {
+        // the leading null tells maps apart from lists on the Dart side
+        const size_t length = fl_value_get_length(value);
+        CObject **values = NewArray(object, 1 + 2 * length);
+        values[0] = &objects_.emplace_back();
+        values[0]->type = kNull;
+        for (size_t i = 0; i < length; i++)
+        {
+          values[1 + 2 * i] = Encode(fl_value_get_map_key(value, i));
+          values[2 + 2 * i] = Encode(fl_value_get_map_value(value, i));
+        }
+        break;
+      }
+      default:
+        break;
+      }
+      return object;
+    }
+
+  private:
+    static void SetTypedData(CObject *object, TypedDataType type, const void *values, size_t length)
+    {
+      object->type = kTypedData;
+      object->value.as_typed_data.type = type;
+      object->value.as_typed_data.length = length;
+      object->value.as_typed_data.values = values;
+    }
+
+    CObject **NewArray(CObject *object, size_t length)
+    {
+      arrays_.emplace_back(new CObject *[length]);
+      object->type = kArray;
+      object->value.as_array.length = length;
+      object->value.as_array.values = arrays_.back().get();
+      return arrays_.back().get();
+    }
+
+    // deque keeps the addresses stable while growing
+    std::deque<CObject> objects_;
+    std::vector<std::unique_ptr<CObject *[]>> arrays_;
+  };
+}
+
+namespace native_port
+{
+  bool IsAvailable()
+  {
+    return g_post.load(std::memory_order_acquire) != nullptr;
+  }
+
+  bool Post(int64_t port, FlValue *message, GError **error)
+  {
+    PostCObjectFunc post = g_post.load(std::memory_order_acquire);
+    if (!post)
+    {
+      g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED, "native port transport not initialized");
+      return false;
+    }
+    Encoder encoder;
+    if (!post(port, encoder.Encode(message)))
+    {
+      g_set_error(error, G_IO_ERROR, G_IO_ERROR_CLOSED, "port %" G_GINT64_FORMAT " is closed", port);
+      return false;
+    }
+    return true;
+  }
+}
+
+void dart_cef_native_port_init(void *post_cobject)
+{
+  g_post.store(reinterpret_cast<PostCObjectFunc>(post_cobject), std::memory_order_release);
+}
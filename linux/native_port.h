@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include <flutter_linux/flutter_linux.h>
+
+// Event transport posting straight to a Dart ReceivePort with
+// Dart_PostCObject, which is safe from any thread. Dart hands over the
+// function pointer through dart_cef_native_port_init, so the plugin does not
+// link against the Dart API. Values are converted as they are:
+// strings, numbers and typed lists map to their Dart counterparts, lists to
+// arrays, and maps to arrays of null followed by the keys and values.
+namespace native_port
+{
+  bool IsAvailable();
+
+  // Posts |message| to |port|, false if the port is closed or the transport
+  // was not initialized.
+  bool Post(int64_t port, FlValue *message, GError **error);
+}
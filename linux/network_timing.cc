@@ -0,0 +1,200 @@
+#include "network_timing.h"
+
+namespace network_timing
+{
+  // static
+  Registry *Registry::GetInstance()
+  {
+    static Registry instance;
+    return &instance;
+  }
+
+  // static
+  Page &Registry::CurrentPage(Entry &entry, std::chrono::steady_clock::time_point now)
+  {
+    auto [it, inserted] = entry.pages.try_emplace(entry.current_page);
+    if (inserted)
+    {
+      it->second.id = entry.current_page;
+      it->second.origin = now;
+    }
+    return it->second;
+  }
+
+  void Registry::SetEnabled(int browser_id, bool enabled)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (enabled && it == entries_.end())
+    {
+      entries_[browser_id];
+      enabled_count_++;
+    }
+    else if (!enabled && it != entries_.end())
+    {
+      entries_.erase(it);
+      enabled_count_--;
+    }
+  }
+
+  void Registry::Remove(int browser_id)
+  {
+    SetEnabled(browser_id, false);
+  }
+
+  void Registry::Copy(int from_browser_id, int to_browser_id)
+  {
+    bool enabled;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      enabled = entries_.count(from_browser_id) > 0;
+    }
+    if (enabled)
+    {
+      SetEnabled(to_browser_id, true);
+    }
+  }
+
+  void Registry::OnRequestStart(int browser_id, CefRefPtr<CefRequest> request)
+  {
+    if (enabled_count_.load(std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it == entries_.end())
+    {
+      return;
+    }
+    Entry &entry = it->second;
+    // redirects keep the identifier and the original start
+    const uint64_t id = request->GetIdentifier();
+    if (entry.pending.count(id))
+    {
+      return;
+    }
+    if (request->GetResourceType() == RT_MAIN_FRAME)
+    {
+      entry.current_page++;
+    }
+    Page &page = CurrentPage(entry, now);
+    if (entry.pending.size() >= kMaxRequests)
+    {
+      // long-lived requests that never complete must not pile up
+      page.dropped++;
+      return;
+    }
+    Request &pending = entry.pending[id];
+    pending.url = request->GetURL();
+    pending.type = request->GetResourceType();
+    pending.start = now;
+    pending.page = page.id;
+    pending.page_origin = page.origin;
+  }
+
+  void Registry::OnResponseStart(int browser_id, CefRefPtr<CefRequest> request, CefRefPtr<CefResponse> response)
+  {
+    if (enabled_count_.load(std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it == entries_.end())
+    {
+      return;
+    }
+    auto pending = it->second.pending.find(request->GetIdentifier());
+    if (pending != it->second.pending.end() && !pending->second.response_start)
+    {
+      pending->second.response_start = now;
+    }
+  }
+
+  void Registry::OnRequestComplete(int browser_id,
+                                   CefRefPtr<CefRequest> request,
+                                   CefRefPtr<CefResponse> response,
+                                   cef_urlrequest_status_t status,
+                                   int64_t received_bytes)
+  {
+    if (enabled_count_.load(std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it == entries_.end())
+    {
+      return;
+    }
+    auto pending = it->second.pending.find(request->GetIdentifier());
+    if (pending == it->second.pending.end())
+    {
+      // started before the browser was observed
+      return;
+    }
+    auto [page_it, inserted] = it->second.pages.try_emplace(pending->second.page);
+    Page &page = page_it->second;
+    if (inserted)
+    {
+      // taken before, late requests are reported against the same origin
+      page.id = pending->second.page;
+      page.origin = pending->second.page_origin;
+    }
+    if (page.requests.size() >= kMaxRequests)
+    {
+      page.dropped++;
+    }
+    else
+    {
+      Request &completed = pending->second;
+      completed.end = now;
+      completed.received_bytes = received_bytes;
+      completed.http_status = response ? response->GetStatus() : 0;
+      completed.result = status;
+      page.requests.push_back(std::move(completed));
+    }
+    it->second.pending.erase(pending);
+  }
+
+  std::optional<std::vector<Page>> Registry::TakePages(int browser_id, bool previous_only)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it == entries_.end())
+    {
+      return std::nullopt;
+    }
+    Entry &entry = it->second;
+    std::vector<Page> pages;
+    for (auto page = entry.pages.begin(); page != entry.pages.end();)
+    {
+      const bool current = page->first == entry.current_page;
+      if (current && previous_only)
+      {
+        ++page;
+        continue;
+      }
+      if (!page->second.requests.empty() || page->second.dropped > 0)
+      {
+        pages.push_back(std::move(page->second));
+      }
+      if (current)
+      {
+        // keeps the origin for requests completing later
+        page->second.requests.clear();
+        page->second.dropped = 0;
+        ++page;
+      }
+      else
+      {
+        page = entry.pages.erase(page);
+      }
+    }
+    return pages;
+  }
+}
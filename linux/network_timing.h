@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "include/cef_request.h"
+#include "include/cef_resource_request_handler.h"
+#include "include/cef_response.h"
+
+// Records when every request of a browser started, when its response
+// headers arrived, when it completed and how many bytes it received, to find
+// slow backends without a proxy. Fed by ResourceRequestHandler on the IO
+// thread, the requests of a page load are collected on the UI thread when
+// loading stops. Every main frame request starts a new page, requests
+// completing after their page stopped loading are collected with the next
+// navigation under the page they belong to.
+namespace network_timing
+{
+  // requests kept per page load, later ones are only counted
+  constexpr size_t kMaxRequests = 2000;
+
+  struct Request
+  {
+    std::string url;
+    cef_resource_type_t type = RT_SUB_RESOURCE;
+    std::chrono::steady_clock::time_point start;
+    // unset if the request failed before any response
+    std::optional<std::chrono::steady_clock::time_point> response_start;
+    std::chrono::steady_clock::time_point end;
+    int64_t received_bytes = 0;
+    int http_status = 0;
+    cef_urlrequest_status_t result = UR_UNKNOWN;
+    // the page that was loading when the request started and its origin
+    uint64_t page = 0;
+    std::chrono::steady_clock::time_point page_origin;
+  };
+
+  struct Page
+  {
+    uint64_t id = 0;
+    // start of the page's first request, the times are reported relative to it
+    std::chrono::steady_clock::time_point origin;
+    // sorted by completion
+    std::vector<Request> requests;
+    // requests beyond kMaxRequests
+    uint32_t dropped = 0;
+  };
+
+  class Registry
+  {
+  public:
+    static Registry *GetInstance();
+
+    void SetEnabled(int browser_id, bool enabled);
+
+    // Forgets the browser and its pending requests.
+    void Remove(int browser_id);
+
+    // Observes |to_browser_id| if |from_browser_id| is observed.
+    void Copy(int from_browser_id, int to_browser_id);
+
+    void OnRequestStart(int browser_id, CefRefPtr<CefRequest> request);
+
+    void OnResponseStart(int browser_id, CefRefPtr<CefRequest> request, CefRefPtr<CefResponse> response);
+
+    void OnRequestComplete(int browser_id,
+                           CefRefPtr<CefRequest> request,
+                           CefRefPtr<CefResponse> response,
+                           cef_urlrequest_status_t status,
+                           int64_t received_bytes);
+
+    // Returns the requests completed since the last call, one entry per page
+    // that has any. Only pages before the current one if |previous_only|.
+    // Nothing if the browser is not observed.
+    std::optional<std::vector<Page>> TakePages(int browser_id, bool previous_only);
+
+  private:
+    Registry() = default;
+
+    struct Entry
+    {
+      // Map of request identifier -> request in flight
+      std::map<uint64_t, Request> pending;
+      // Map of page id -> requests completed and not taken yet
+      std::map<uint64_t, Page> pages;
+      uint64_t current_page = 0;
+    };
+
+    // Returns the current page of |entry|, started at |now| if new.
+    static Page &CurrentPage(Entry &entry, std::chrono::steady_clock::time_point now);
+
+    // lets the hooks skip the lock while no browser is observed
+    std::atomic<int> enabled_count_{0};
+
+    std::mutex mutex_;
+
+    // Map of browser id -> observed requests
+    std::map<int, Entry> entries_;
+  };
+}
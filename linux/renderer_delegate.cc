@@ -4,14 +4,18 @@
 
 #include "renderer_delegate.h"
 
+#include <map>
+#include <memory>
 #include <sstream>
 #include <string>
-#include <fmt/core.h>
+#include <unistd.h>
 
 #include "include/cef_crash_util.h"
 #include "include/cef_dom.h"
 #include "include/wrapper/cef_helpers.h"
 #include "include/wrapper/cef_message_router.h"
+#include "async_log.h"
+#include "token_accessor.h"
 #include "v8handler.h"
 #include "client_renderer.h"
 
@@ -57,7 +61,7 @@ namespace client
 
         void OnWebKitInitialized(CefRefPtr<ClientAppRenderer> app) override
         {
-          LOG(INFO) << "OnWebKitInitialized!";
+          ALOG(Info, "OnWebKitInitialized!");
           // Create the renderer-side router for query handling.
           CefMessageRouterConfig config;
           message_router_ = CefMessageRouterRendererSide::Create(config);
@@ -68,7 +72,7 @@ namespace client
                               CefRefPtr<CefFrame> frame,
                               CefRefPtr<CefV8Context> context) override
         {
-          LOG(INFO) << "OnContextCreated!";
+          ALOG_EVERY_MS(Debug, 1000, "OnContextCreated!");
           // Retrieve the context's window object.
           CefRefPtr<CefV8Value> object = context->GetGlobal();
 
@@ -78,10 +82,15 @@ namespace client
           if (frame->IsMain())
           {
             CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(client::renderer::kContextCreated);
+            // a cross-site navigation may have moved the browser to this process
+            message->GetArgumentList()->SetInt(0, getpid());
             browser->GetMainFrame()->SendProcessMessage(PID_BROWSER, message);
-            const auto js = fmt::format("localStorage.setItem('token', '{}'); localStorage.setItem('access_token', '{}');", token_, access_token_);
-            LOG(INFO) << "executing " << js;
-            browser->GetMainFrame()->ExecuteJavaScript(js, frame->GetURL(), 0);
+            // no script or storage write per navigation, the accessor reads the live values
+            CefRefPtr<CefV8Value> tokens = CefV8Value::CreateObject(new TokenAccessor(getTokens(browser)), nullptr);
+            tokens->SetValue("token", V8_ACCESS_CONTROL_DEFAULT, V8_PROPERTY_ATTRIBUTE_READONLY);
+            tokens->SetValue("access_token", V8_ACCESS_CONTROL_DEFAULT, V8_PROPERTY_ATTRIBUTE_READONLY);
+            object->SetValue(kTokenObject, tokens,
+                             static_cast<cef_v8_propertyattribute_t>(V8_PROPERTY_ATTRIBUTE_READONLY | V8_PROPERTY_ATTRIBUTE_DONTDELETE));
           }
 
           // Create an instance of my CefV8Handler object.
@@ -100,7 +109,7 @@ namespace client
               return false;
             } });
 
-          LOG(INFO) << "creating " << bind_func_ << " function handler";
+          ALOG_EVERY_MS(Debug, 1000, "creating {} function handler", bind_func_.ToString());
           CefRefPtr<CefV8Value> func = CefV8Value::CreateFunction(bind_func_, handler);
 
           // Add the "myfunc" function to the "window" object.
@@ -116,18 +125,14 @@ namespace client
           CefRefPtr<CefListValue> args = message->GetArgumentList();
           texture_id_ = extra_info->GetString("texture_id");
           bind_func_ = extra_info->GetString("bind_func");
-          std::string token = extra_info->GetString("token");
-          if (token != "")
-          {
-            token_ = token;
-          }
-          std::string access_token = extra_info->GetString("access_token");
-          if (access_token != "")
-          {
-            access_token_ = access_token;
-          }
-          LOG(INFO) << "created browser with token " << token_ << " and access_token " << access_token_;
+          auto &tokens = tokens_[browser->GetIdentifier()];
+          tokens = std::make_shared<TokenValues>();
+          tokens->token = extra_info->GetString("token");
+          tokens->access_token = extra_info->GetString("access_token");
+          ALOG(Info, "created browser with {} token and {} access token", tokens->token.empty() ? "no" : "a", tokens->access_token.empty() ? "no" : "an");
           args->SetString(0, texture_id_);
+          // lets the browser process attribute renderer cpu and memory to this browser
+          args->SetInt(1, getpid());
           CefRefPtr<CefFrame> frame = browser->GetMainFrame();
           if (frame)
           {
@@ -137,6 +142,7 @@ namespace client
 
         void OnBrowserDestroyed(CefRefPtr<ClientAppRenderer> app, CefRefPtr<CefBrowser> browser) override
         {
+          tokens_.erase(browser->GetIdentifier());
         }
 
         void OnContextReleased(CefRefPtr<ClientAppRenderer> app,
@@ -144,7 +150,7 @@ namespace client
                                CefRefPtr<CefFrame> frame,
                                CefRefPtr<CefV8Context> context) override
         {
-          LOG(INFO) << "OnContextReleased!";
+          ALOG_EVERY_MS(Debug, 1000, "OnContextReleased!");
           // message_router_->OnContextReleased(browser, frame, context);
         }
 
@@ -173,20 +179,20 @@ namespace client
         {
           const std::string &message_name = message->GetName();
 
-          LOG(INFO) << "renderer recieved " << message_name << " message";
+          ALOG_EVERY_MS(Debug, 1000, "renderer recieved {} message", message_name);
           if (message_name == client::renderer::kTokenUpdate)
           {
             std::string new_token = message->GetArgumentList()->GetString(0).ToString();
-            LOG(INFO) << "renderer update token to " << new_token;
-            token_ = new_token;
+            ALOG(Debug, "renderer update token");
+            getTokens(browser)->token = new_token;
             CefRefPtr<CefProcessMessage> to_browser = CefProcessMessage::Create(client::renderer::kTokenUpdate);
             browser->GetMainFrame()->SendProcessMessage(PID_BROWSER, to_browser);
           }
           if (message_name == client::renderer::kAccessTokenUpdate)
           {
             std::string new_token = message->GetArgumentList()->GetString(0).ToString();
-            LOG(INFO) << "renderer update access token to " << new_token;
-            access_token_ = new_token;
+            ALOG(Debug, "renderer update access token");
+            getTokens(browser)->access_token = new_token;
             CefRefPtr<CefProcessMessage> to_browser = CefProcessMessage::Create(client::renderer::kAccessTokenUpdate);
             browser->GetMainFrame()->SendProcessMessage(PID_BROWSER, to_browser);
           }
@@ -204,11 +210,22 @@ namespace client
         }
 
       private:
+        std::shared_ptr<TokenValues> getTokens(CefRefPtr<CefBrowser> browser)
+        {
+          auto &tokens = tokens_[browser->GetIdentifier()];
+          if (!tokens)
+          {
+            tokens = std::make_shared<TokenValues>();
+          }
+          return tokens;
+        }
+
         bool last_node_is_editable_;
         CefString bind_func_;
         CefString texture_id_;
-        std::string token_;
-        std::string access_token_;
+
+        // Map of browser id -> tokens, shared with the accessors of its contexts
+        std::map<int, std::shared_ptr<TokenValues>> tokens_;
 
         // Handles the renderer side of query routing.
         CefRefPtr<CefMessageRouterRendererSide> message_router_;
@@ -220,7 +237,6 @@ namespace client
 
     void CreateDelegates(ClientAppRenderer::DelegateSet &delegates)
     {
-      LOG(INFO) << "CreateDelegates!";
       delegates.insert(new ClientRenderDelegate);
     }
 
@@ -24,6 +24,10 @@ namespace client
         const char kTokenUpdate[] = "ClientRenderer.TokenUpdate";
         const char kAccessTokenUpdate[] = "ClientRenderer.AccessTokenUpdate";
 
+        // Global object of main frames whose read-only "token" and
+        // "access_token" properties return the browser's current tokens.
+        const char kTokenObject[] = "dartCefTokens";
+
         // Create the renderer delegate. Called from client_app_delegates_renderer.cc.
         void CreateDelegates(ClientAppRenderer::DelegateSet &delegates);
 
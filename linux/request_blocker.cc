@@ -0,0 +1,595 @@
+#include "request_blocker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <sstream>
+#include <unordered_set>
+
+namespace request_blocker
+{
+  namespace
+  {
+    constexpr size_t kMinKeyword = 3;
+
+    constexpr uint32_t Bit(cef_resource_type_t type)
+    {
+      return 1u << type;
+    }
+
+    // EasyList rules don't apply to top level documents unless they say so
+    constexpr uint32_t kDefaultTypes = ~(Bit(RT_MAIN_FRAME) | Bit(RT_NAVIGATION_PRELOAD_MAIN_FRAME));
+
+    const std::map<std::string, uint32_t> kTypeOptions = {
+        {"script", Bit(RT_SCRIPT)},
+        {"image", Bit(RT_IMAGE) | Bit(RT_FAVICON)},
+        {"stylesheet", Bit(RT_STYLESHEET)},
+        {"xmlhttprequest", Bit(RT_XHR)},
+        {"subdocument", Bit(RT_SUB_FRAME) | Bit(RT_NAVIGATION_PRELOAD_SUB_FRAME)},
+        {"media", Bit(RT_MEDIA)},
+        {"font", Bit(RT_FONT_RESOURCE)},
+        {"object", Bit(RT_OBJECT) | Bit(RT_PLUGIN_RESOURCE)},
+        {"ping", Bit(RT_PING) | Bit(RT_CSP_REPORT)},
+        {"document", Bit(RT_MAIN_FRAME) | Bit(RT_NAVIGATION_PRELOAD_MAIN_FRAME)},
+        {"other", Bit(RT_SUB_RESOURCE) | Bit(RT_PREFETCH) | Bit(RT_WORKER) | Bit(RT_SHARED_WORKER) | Bit(RT_SERVICE_WORKER)},
+    };
+
+    std::string Trim(const std::string &value)
+    {
+      const auto begin = value.find_first_not_of(" \t\r");
+      if (begin == std::string::npos)
+      {
+        return "";
+      }
+      const auto end = value.find_last_not_of(" \t\r");
+      return value.substr(begin, end - begin + 1);
+    }
+
+    std::string ToLower(std::string value)
+    {
+      std::transform(value.begin(), value.end(), value.begin(),
+                     [](unsigned char c)
+                     { return std::tolower(c); });
+      return value;
+    }
+
+    bool IsSeparator(char c)
+    {
+      return !(std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.' || c == '%');
+    }
+
+    bool IsHostName(const std::string &value)
+    {
+      return !value.empty() && value.find('.') != std::string::npos &&
+             std::all_of(value.begin(), value.end(), [](unsigned char c)
+                         { return std::isalnum(c) || c == '.' || c == '-'; });
+    }
+
+    // '*' matches any sequence, '^' a separator or the end of the url.
+    bool GlobMatch(const std::string &pattern, const std::string &url, size_t pos, bool anchor_end)
+    {
+      size_t pi = 0;
+      size_t si = pos;
+      size_t star_pi = std::string::npos;
+      size_t star_si = 0;
+      for (;;)
+      {
+        if (pi == pattern.size())
+        {
+          if (!anchor_end || si == url.size())
+          {
+            return true;
+          }
+        }
+        else if (pattern[pi] == '*')
+        {
+          star_pi = pi++;
+          star_si = si;
+          continue;
+        }
+        else if (pattern[pi] == '^' && si == url.size())
+        {
+          pi++;
+          continue;
+        }
+        else if (si < url.size() && (pattern[pi] == '^' ? IsSeparator(url[si]) : pattern[pi] == url[si]))
+        {
+          pi++;
+          si++;
+          continue;
+        }
+        if (star_pi == std::string::npos || star_si >= url.size())
+        {
+          return false;
+        }
+        pi = star_pi + 1;
+        si = ++star_si;
+      }
+    }
+
+    std::string Keyword(const std::string &pattern)
+    {
+      std::string best;
+      size_t begin = 0;
+      while (begin <= pattern.size())
+      {
+        auto end = pattern.find_first_of("*^", begin);
+        if (end == std::string::npos)
+        {
+          end = pattern.size();
+        }
+        if (end - begin > best.size())
+        {
+          best = pattern.substr(begin, end - begin);
+        }
+        begin = end + 1;
+      }
+      return best;
+    }
+
+    void FindHost(const std::string &url, size_t &host_begin, size_t &host_end)
+    {
+      const auto scheme = url.find("://");
+      host_begin = scheme == std::string::npos ? 0 : scheme + 3;
+      host_end = url.find_first_of("/?#", host_begin);
+      if (host_end == std::string::npos)
+      {
+        host_end = url.size();
+      }
+      const auto at = url.rfind('@', host_end);
+      if (at != std::string::npos && at >= host_begin)
+      {
+        host_begin = at + 1;
+      }
+      const auto colon = url.find(':', host_begin);
+      if (colon != std::string::npos && colon < host_end)
+      {
+        host_end = colon;
+      }
+    }
+
+    // Approximates the registrable domain with the last two labels, three
+    // for hosts like example.co.uk.
+    std::string SiteOf(const std::string &host)
+    {
+      const auto last = host.rfind('.');
+      if (last == std::string::npos || last == 0)
+      {
+        return host;
+      }
+      auto second = host.rfind('.', last - 1);
+      if (second != std::string::npos && host.size() - last - 1 == 2 && last - second - 1 <= 3 && second > 0)
+      {
+        second = host.rfind('.', second - 1);
+      }
+      return second == std::string::npos ? host : host.substr(second + 1);
+    }
+
+    enum class ParseResult
+    {
+      Skip,
+      Host,
+      Pattern
+    };
+
+    ParseResult ParseLine(const std::string &raw, Rule &rule, std::string &host, bool &exception)
+    {
+      std::string line = Trim(raw);
+      exception = false;
+      if (line.empty() || line[0] == '!' || line[0] == '[' || line[0] == '#' ||
+          line.find("##") != std::string::npos || line.find("#@#") != std::string::npos ||
+          line.find("#?#") != std::string::npos)
+      {
+        return ParseResult::Skip;
+      }
+
+      // hosts file entries
+      for (const char *prefix : {"0.0.0.0 ", "127.0.0.1 "})
+      {
+        if (line.compare(0, strlen(prefix), prefix) == 0)
+        {
+          host = ToLower(Trim(line.substr(strlen(prefix))));
+          return IsHostName(host) ? ParseResult::Host : ParseResult::Skip;
+        }
+      }
+
+      if (line.compare(0, 2, "@@") == 0)
+      {
+        exception = true;
+        line = line.substr(2);
+      }
+
+      const auto dollar = line.rfind('$');
+      if (dollar != std::string::npos)
+      {
+        std::istringstream options(line.substr(dollar + 1));
+        line = line.substr(0, dollar);
+        std::string option;
+        uint32_t include = 0;
+        uint32_t exclude = 0;
+        while (std::getline(options, option, ','))
+        {
+          option = ToLower(Trim(option));
+          const bool negated = !option.empty() && option[0] == '~';
+          const std::string name = negated ? option.substr(1) : option;
+          if (name == "third-party")
+          {
+            rule.third_party = negated ? 0 : 1;
+            continue;
+          }
+          auto it = kTypeOptions.find(name);
+          if (it == kTypeOptions.end())
+          {
+            // unknown semantics, better not to block at all
+            return ParseResult::Skip;
+          }
+          (negated ? exclude : include) |= it->second;
+        }
+        if (include || exclude)
+        {
+          rule.types = (include ? include : kDefaultTypes) & ~exclude;
+        }
+      }
+
+      if (line.compare(0, 2, "||") == 0)
+      {
+        rule.anchor_domain = true;
+        line = line.substr(2);
+      }
+      else if (!line.empty() && line[0] == '|')
+      {
+        rule.anchor_start = true;
+        line = line.substr(1);
+      }
+      if (!line.empty() && line.back() == '|')
+      {
+        rule.anchor_end = true;
+        line.pop_back();
+      }
+      line = ToLower(line);
+      while (!line.empty() && line.front() == '*' && !rule.anchor_domain && !rule.anchor_start)
+      {
+        line.erase(0, 1);
+      }
+      while (!line.empty() && line.back() == '*' && !rule.anchor_end)
+      {
+        line.pop_back();
+      }
+      if (line.empty())
+      {
+        return ParseResult::Skip;
+      }
+
+      const bool defaults = rule.types == 0 && rule.third_party == -1 && !rule.anchor_start && !rule.anchor_end;
+      std::string bare = line;
+      if (rule.anchor_domain && !bare.empty() && bare.back() == '^')
+      {
+        bare.pop_back();
+      }
+      if (defaults && (rule.anchor_domain || line == bare) && IsHostName(bare))
+      {
+        host = bare;
+        return ParseResult::Host;
+      }
+      rule.pattern = line;
+      return ParseResult::Pattern;
+    }
+  }
+
+  void RuleSet::Add(Rule rule)
+  {
+    rules_.push_back(std::move(rule));
+  }
+
+  void RuleSet::AddHost(std::string host)
+  {
+    hosts_.insert(std::move(host));
+  }
+
+  void RuleSet::Compile()
+  {
+    states_.assign(1, State());
+    edges_.clear();
+    unindexed_.clear();
+
+    for (size_t index = 0; index < rules_.size(); index++)
+    {
+      Rule &rule = rules_[index];
+      rule.prefix = rule.pattern.substr(0, rule.pattern.find_first_of("*^"));
+      const std::string keyword = Keyword(rule.pattern);
+      if (keyword.size() < kMinKeyword)
+      {
+        unindexed_.push_back(index);
+        continue;
+      }
+      int state = 0;
+      for (unsigned char c : keyword)
+      {
+        const uint64_t key = static_cast<uint64_t>(state) << 8 | c;
+        auto it = edges_.find(key);
+        if (it == edges_.end())
+        {
+          states_.emplace_back();
+          it = edges_.emplace(key, static_cast<int>(states_.size() - 1)).first;
+        }
+        state = it->second;
+      }
+      states_[state].outputs.push_back(index);
+    }
+
+    // breadth first over the trie to set fail links, children by parent
+    std::vector<std::vector<std::pair<unsigned char, int>>> children(states_.size());
+    for (const auto &[key, child] : edges_)
+    {
+      children[key >> 8].emplace_back(static_cast<unsigned char>(key & 0xff), child);
+    }
+    std::deque<int> queue;
+    for (const auto &[c, child] : children[0])
+    {
+      states_[child].fail = 0;
+      queue.push_back(child);
+    }
+    while (!queue.empty())
+    {
+      const int state = queue.front();
+      queue.pop_front();
+      for (const auto &[c, child] : children[state])
+      {
+        const int fail = Next(states_[state].fail, c);
+        states_[child].fail = fail;
+        const auto &inherited = states_[fail].outputs;
+        states_[child].outputs.insert(states_[child].outputs.end(), inherited.begin(), inherited.end());
+        queue.push_back(child);
+      }
+    }
+  }
+
+  int RuleSet::Next(int state, unsigned char c) const
+  {
+    for (;;)
+    {
+      auto it = edges_.find(static_cast<uint64_t>(state) << 8 | c);
+      if (it != edges_.end())
+      {
+        return it->second;
+      }
+      if (state == 0)
+      {
+        return 0;
+      }
+      state = states_[state].fail;
+    }
+  }
+
+  bool RuleSet::MatchesRule(const Rule &rule, const std::string &url, size_t host_begin, size_t host_end,
+                            cef_resource_type_t type, bool third_party) const
+  {
+    if (!((rule.types ? rule.types : kDefaultTypes) & Bit(type)))
+    {
+      return false;
+    }
+    if (rule.third_party != -1 && rule.third_party != static_cast<int>(third_party))
+    {
+      return false;
+    }
+    if (rule.anchor_start)
+    {
+      return GlobMatch(rule.pattern, url, 0, rule.anchor_end);
+    }
+    if (rule.anchor_domain)
+    {
+      for (size_t pos = host_begin; pos < host_end; pos++)
+      {
+        if ((pos == host_begin || url[pos - 1] == '.') &&
+            url.compare(pos, rule.prefix.size(), rule.prefix) == 0 &&
+            GlobMatch(rule.pattern, url, pos, rule.anchor_end))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+    if (rule.prefix.empty())
+    {
+      for (size_t pos = 0; pos < url.size(); pos++)
+      {
+        if (GlobMatch(rule.pattern, url, pos, rule.anchor_end))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+    // only offsets where the literal start occurs can match
+    for (size_t pos = url.find(rule.prefix); pos != std::string::npos; pos = url.find(rule.prefix, pos + 1))
+    {
+      if (GlobMatch(rule.pattern, url, pos, rule.anchor_end))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool RuleSet::Matches(const std::string &url, size_t host_begin, size_t host_end,
+                        cef_resource_type_t type, bool third_party) const
+  {
+    if (!hosts_.empty() && (kDefaultTypes & Bit(type)))
+    {
+      // the host itself and every parent domain
+      for (size_t pos = host_begin; pos < host_end; pos++)
+      {
+        if ((pos == host_begin || url[pos - 1] == '.') &&
+            hosts_.count(url.substr(pos, host_end - pos)))
+        {
+          return true;
+        }
+      }
+    }
+
+    // a keyword found several times only needs one full check
+    std::unordered_set<size_t> checked;
+    int state = 0;
+    for (unsigned char c : url)
+    {
+      state = Next(state, c);
+      for (size_t index : states_[state].outputs)
+      {
+        if (!checked.insert(index).second)
+        {
+          continue;
+        }
+        if (MatchesRule(rules_[index], url, host_begin, host_end, type, third_party))
+        {
+          return true;
+        }
+      }
+    }
+
+    for (size_t index : unindexed_)
+    {
+      if (MatchesRule(rules_[index], url, host_begin, host_end, type, third_party))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // static
+  std::shared_ptr<const FilterList> FilterList::Compile(const std::string &text, size_t &rule_count)
+  {
+    auto list = std::make_shared<FilterList>();
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      Rule rule;
+      std::string host;
+      bool exception = false;
+      switch (ParseLine(line, rule, host, exception))
+      {
+      case ParseResult::Host:
+        (exception ? list->allow_ : list->block_).AddHost(std::move(host));
+        break;
+      case ParseResult::Pattern:
+        (exception ? list->allow_ : list->block_).Add(std::move(rule));
+        break;
+      case ParseResult::Skip:
+        break;
+      }
+    }
+    list->block_.Compile();
+    list->allow_.Compile();
+    rule_count = list->block_.size() + list->allow_.size();
+    return list;
+  }
+
+  bool FilterList::ShouldBlock(const std::string &url, cef_resource_type_t type, bool third_party) const
+  {
+    size_t host_begin = 0;
+    size_t host_end = 0;
+    FindHost(url, host_begin, host_end);
+    return block_.Matches(url, host_begin, host_end, type, third_party) &&
+           !allow_.Matches(url, host_begin, host_end, type, third_party);
+  }
+
+  bool IsThirdParty(const std::string &url, const std::string &first_party_url)
+  {
+    if (first_party_url.empty())
+    {
+      return false;
+    }
+    const std::string lower = ToLower(url);
+    const std::string first_party = ToLower(first_party_url);
+    size_t begin, end, first_begin, first_end;
+    FindHost(lower, begin, end);
+    FindHost(first_party, first_begin, first_end);
+    return SiteOf(lower.substr(begin, end - begin)) !=
+           SiteOf(first_party.substr(first_begin, first_end - first_begin));
+  }
+
+  // static
+  Registry *Registry::GetInstance()
+  {
+    static Registry instance;
+    return &instance;
+  }
+
+  void Registry::SetFilterList(int browser_id, std::shared_ptr<const FilterList> list, size_t rules)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = entries_[browser_id];
+    entry.list = std::move(list);
+    entry.stats.rules = entry.list ? rules : 0;
+  }
+
+  void Registry::Remove(int browser_id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(browser_id);
+  }
+
+  void Registry::Copy(int from_browser_id, int to_browser_id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(from_browser_id);
+    if (it != entries_.end())
+    {
+      entries_[to_browser_id].list = it->second.list;
+      entries_[to_browser_id].stats.rules = it->second.stats.rules;
+    }
+  }
+
+  bool Registry::ShouldBlock(int browser_id, const std::string &url, const std::string &first_party_url,
+                             cef_resource_type_t type)
+  {
+    std::shared_ptr<const FilterList> list;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(browser_id);
+      if (it == entries_.end() || !it->second.list)
+      {
+        return false;
+      }
+      list = it->second.list;
+    }
+
+    const std::string lower = ToLower(url);
+    if (!list->ShouldBlock(lower, type, IsThirdParty(lower, first_party_url)))
+    {
+      return false;
+    }
+
+    const int slot = type < kTypeCount ? type : 0;
+    const uint64_t count = response_count_[slot].load(std::memory_order_relaxed);
+    const uint64_t average = count ? response_bytes_[slot].load(std::memory_order_relaxed) / count : 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    if (it != entries_.end())
+    {
+      it->second.stats.blocked_requests++;
+      it->second.stats.estimated_bytes_saved += average;
+    }
+    return true;
+  }
+
+  void Registry::OnResponseSize(cef_resource_type_t type, int64_t bytes)
+  {
+    if (type >= kTypeCount || bytes <= 0)
+    {
+      return;
+    }
+    response_bytes_[type].fetch_add(bytes, std::memory_order_relaxed);
+    response_count_[type].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Stats Registry::GetStats(int browser_id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(browser_id);
+    return it == entries_.end() ? Stats() : it->second.stats;
+  }
+}
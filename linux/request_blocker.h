@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "include/internal/cef_types.h"
+
+// Blocks subresource requests by URL patterns. Lists are compiled once into
+// a FilterList that is shared immutably with the IO thread:
+//
+//  - host rules ("||example.com^", "example.com", "0.0.0.0 example.com") go
+//    into a hash set that is probed with the host and each parent domain
+//  - other rules are indexed by their longest literal part in an Aho-Corasick
+//    automaton, so a url is scanned once and only rules whose literal occurs
+//    in it are checked in full
+//
+// Supported EasyList syntax: "||", "|" and trailing "|" anchors, "*" and
+// "^" wildcards, "@@" exceptions and the $script, $image, $stylesheet,
+// $xmlhttprequest, $subdocument, $media, $font, $object, $ping, $document,
+// $other and $third-party options (optionally negated with "~"). Rules with
+// other options and cosmetic rules are skipped.
+namespace request_blocker
+{
+  struct Rule
+  {
+    // lower case, may contain '*' and '^'
+    std::string pattern;
+    // literal start of |pattern|, set by RuleSet::Compile
+    std::string prefix;
+    bool anchor_start = false;
+    bool anchor_end = false;
+    bool anchor_domain = false;
+    // bit mask of cef_resource_type_t, 0 for the default types
+    uint32_t types = 0;
+    // -1 any, 0 first party only, 1 third party only
+    int third_party = -1;
+  };
+
+  class RuleSet
+  {
+  public:
+    void Add(Rule rule);
+
+    void AddHost(std::string host);
+
+    // Builds the automaton, must be called once after all rules are added.
+    // The matching below only reads, a compiled set is safe to share.
+    void Compile();
+
+    bool Matches(const std::string &url, size_t host_begin, size_t host_end,
+                 cef_resource_type_t type, bool third_party) const;
+
+    size_t size() const { return hosts_.size() + rules_.size(); }
+
+  private:
+    bool MatchesRule(const Rule &rule, const std::string &url, size_t host_begin, size_t host_end,
+                     cef_resource_type_t type, bool third_party) const;
+
+    int Next(int state, unsigned char c) const;
+
+    // plain host rules, types and party are the defaults
+    std::unordered_set<std::string> hosts_;
+
+    std::vector<Rule> rules_;
+
+    // rules without a literal long enough to index, checked for every url
+    std::vector<size_t> unindexed_;
+
+    // Aho-Corasick automaton over the rules' keywords
+    struct State
+    {
+      int fail = 0;
+      // rules whose keyword ends here, including those reached by fail links
+      std::vector<size_t> outputs;
+    };
+    std::vector<State> states_;
+    // (state << 8 | byte) -> state
+    std::unordered_map<uint64_t, int> edges_;
+  };
+
+  class FilterList
+  {
+  public:
+    // Compiles a newline separated list, |rule_count| receives the number of
+    // rules used.
+    static std::shared_ptr<const FilterList> Compile(const std::string &text, size_t &rule_count);
+
+    // |url| must be lower case.
+    bool ShouldBlock(const std::string &url, cef_resource_type_t type, bool third_party) const;
+
+  private:
+    RuleSet block_;
+    RuleSet allow_;
+  };
+
+  // Whether |url| belongs to another site than |first_party_url|, false if
+  // the latter is empty. Sites are approximated by their last domain labels.
+  bool IsThirdParty(const std::string &url, const std::string &first_party_url);
+
+  struct Stats
+  {
+    uint64_t blocked_requests = 0;
+    uint64_t estimated_bytes_saved = 0;
+    size_t rules = 0;
+  };
+
+  // Filter lists and counters per browser, queried from the IO thread.
+  class Registry
+  {
+  public:
+    static Registry *GetInstance();
+
+    // Installs |list| for |browser_id|, nullptr removes blocking.
+    void SetFilterList(int browser_id, std::shared_ptr<const FilterList> list, size_t rules);
+
+    void Remove(int browser_id);
+
+    // Gives |to_browser_id| the filter list of |from_browser_id|.
+    void Copy(int from_browser_id, int to_browser_id);
+
+    // Returns true and counts the request if it should be blocked.
+    bool ShouldBlock(int browser_id, const std::string &url, const std::string &first_party_url,
+                     cef_resource_type_t type);
+
+    // Feeds the average response size per resource type that is used to
+    // estimate the bytes saved by blocking.
+    void OnResponseSize(cef_resource_type_t type, int64_t bytes);
+
+    Stats GetStats(int browser_id);
+
+  private:
+    Registry() = default;
+
+    struct Entry
+    {
+      std::shared_ptr<const FilterList> list;
+      Stats stats;
+    };
+
+    std::mutex mutex_;
+
+    // Map of browser id -> filter list and counters
+    std::map<int, Entry> entries_;
+
+    // running averages of response sizes per resource type
+    static constexpr int kTypeCount = 32;
+    std::atomic<uint64_t> response_bytes_[kTypeCount] = {};
+    std::atomic<uint64_t> response_count_[kTypeCount] = {};
+  };
+}
@@ -0,0 +1,257 @@
+#include "request_contexts.h"
+
+#include <cctype>
+#include <map>
+#include <mutex>
+
+#include "include/wrapper/cef_helpers.h"
+
+#include "asset_pack.h"
+#include "async_log.h"
+#include "inline_content.h"
+#include "webview.h"
+
+namespace request_contexts
+{
+  namespace
+  {
+    std::string g_root_cache_path;
+
+    std::mutex g_mutex;
+
+    std::string g_default_cache_path;
+
+    // only touched on the UI thread
+    CefRefPtr<CefRequestContext> g_default_context;
+    std::string g_default_context_path;
+    uint64_t g_default_context_id = 0;
+
+    // only touched on the UI thread
+    uint64_t g_next_context_id = 1;
+
+    struct Pooled
+    {
+      CefRefPtr<CefRequestContext> context;
+      uint64_t id = 0;
+      bool persistent = false;
+      // browsers requested with Acquire and not created yet
+      int pending = 0;
+      int browsers = 0;
+    };
+
+    // Map of context key -> shared context, only touched on the UI thread
+    std::map<std::string, Pooled> g_pool;
+
+    // Map of browser id -> key of its pooled context, only touched on the UI
+    // thread
+    std::map<int, std::string> g_browsers;
+
+    std::mutex g_ids_mutex;
+
+    // Map of browser id -> id of its context
+    std::map<int, uint64_t> g_context_ids;
+
+    void SetContextId(int browser_id, uint64_t id)
+    {
+      std::lock_guard<std::mutex> lock(g_ids_mutex);
+      g_context_ids[browser_id] = id;
+    }
+
+    void ReleaseIfUnused(std::map<std::string, Pooled>::iterator it)
+    {
+      if (it->second.pending <= 0 && it->second.browsers <= 0)
+      {
+        g_pool.erase(it);
+      }
+    }
+
+    // Scheme handlers registered with CefRegisterSchemeHandlerFactory only
+    // serve the global context.
+    CefRefPtr<CefRequestContext> CreateContext(const CefRequestContextSettings &settings)
+    {
+      CefRefPtr<CefRequestContext> context = CefRequestContext::CreateContext(settings, nullptr);
+      context->RegisterSchemeHandlerFactory(kAppScheme, inline_content::kHost,
+                                            inline_content::CreateSchemeHandlerFactory());
+      context->RegisterSchemeHandlerFactory(kAppScheme, asset_pack::kHost,
+                                            asset_pack::CreateSchemeHandlerFactory());
+      return context;
+    }
+
+    // Keeps keys usable as a single directory name
+    std::string DirectoryName(const std::string &key)
+    {
+      static const char kHex[] = "0123456789abcdef";
+      std::string name;
+      for (unsigned char c : key)
+      {
+        if (std::isalnum(c) || c == '-')
+        {
+          name += c;
+        }
+        else
+        {
+          name += '_';
+          name += kHex[c >> 4];
+          name += kHex[c & 0xf];
+        }
+      }
+      return name;
+    }
+
+    std::string Resolve(const std::string &path)
+    {
+      if (path.empty() || path[0] == '/' || g_root_cache_path.empty())
+      {
+        return path;
+      }
+      return g_root_cache_path + "/" + path;
+    }
+  }
+
+  void SetRootCachePath(const std::string &path)
+  {
+    g_root_cache_path = path;
+  }
+
+  const std::string &RootCachePath()
+  {
+    return g_root_cache_path;
+  }
+
+  void SetDefaultCachePath(const std::string &path)
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_default_cache_path = Resolve(path);
+  }
+
+  CefRefPtr<CefRequestContext> GetDefault()
+  {
+    CEF_REQUIRE_UI_THREAD();
+    std::string path;
+    {
+      std::lock_guard<std::mutex> lock(g_mutex);
+      path = g_default_cache_path;
+    }
+    if (path.empty())
+    {
+      return nullptr;
+    }
+    if (!g_default_context || g_default_context_path != path)
+    {
+      CefRequestContextSettings settings;
+      CefString(&settings.cache_path).FromString(path);
+      settings.persist_session_cookies = true;
+      g_default_context = CreateContext(settings);
+      g_default_context_path = path;
+      g_default_context_id = g_next_context_id++;
+      ALOG(Info, "Created request context with cache in {}", path);
+    }
+    return g_default_context;
+  }
+
+  CefRefPtr<CefRequestContext> Acquire(const std::string &key, bool persistent)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    if (key.empty())
+    {
+      return GetDefault();
+    }
+    Pooled &pooled = g_pool[key];
+    if (!pooled.context)
+    {
+      CefRequestContextSettings settings;
+      if (persistent)
+      {
+        CefString(&settings.cache_path).FromString(Resolve("contexts/" + DirectoryName(key)));
+        settings.persist_session_cookies = true;
+      }
+      pooled.context = CreateContext(settings);
+      pooled.id = g_next_context_id++;
+      pooled.persistent = persistent;
+      ALOG(Info, "Created {} request context for key {}", persistent ? "on-disk" : "in-memory", key);
+    }
+    else if (pooled.persistent != persistent)
+    {
+      ALOG(Warning, "Request context {} is {}, ignoring the {} storage requested for a new browser", key,
+           pooled.persistent ? "on-disk" : "in-memory", persistent ? "on-disk" : "in-memory");
+    }
+    pooled.pending++;
+    return pooled.context;
+  }
+
+  void Cancel(const std::string &key)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    auto it = g_pool.find(key);
+    if (it != g_pool.end())
+    {
+      it->second.pending--;
+      ReleaseIfUnused(it);
+    }
+  }
+
+  void Attach(CefRefPtr<CefBrowser> browser)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    CefRefPtr<CefRequestContext> context = browser->GetHost()->GetRequestContext();
+    for (auto &[key, pooled] : g_pool)
+    {
+      if (context && context->IsSame(pooled.context))
+      {
+        if (pooled.pending > 0)
+        {
+          pooled.pending--;
+        }
+        pooled.browsers++;
+        g_browsers[browser->GetIdentifier()] = key;
+        SetContextId(browser->GetIdentifier(), pooled.id);
+        return;
+      }
+    }
+    if (!context || context->IsGlobal())
+    {
+      SetContextId(browser->GetIdentifier(), 0);
+    }
+    else if (g_default_context && context->IsSame(g_default_context))
+    {
+      SetContextId(browser->GetIdentifier(), g_default_context_id);
+    }
+    else
+    {
+      // a default context replaced since, its browsers share with nobody
+      SetContextId(browser->GetIdentifier(), g_next_context_id++);
+    }
+  }
+
+  void Detach(int browser_id)
+  {
+    CEF_REQUIRE_UI_THREAD();
+    {
+      std::lock_guard<std::mutex> lock(g_ids_mutex);
+      g_context_ids.erase(browser_id);
+    }
+    auto browser = g_browsers.find(browser_id);
+    if (browser == g_browsers.end())
+    {
+      return;
+    }
+    auto it = g_pool.find(browser->second);
+    g_browsers.erase(browser);
+    if (it != g_pool.end())
+    {
+      it->second.browsers--;
+      ReleaseIfUnused(it);
+    }
+  }
+
+  std::optional<uint64_t> ContextId(int browser_id)
+  {
+    std::lock_guard<std::mutex> lock(g_ids_mutex);
+    auto it = g_context_ids.find(browser_id);
+    if (it == g_context_ids.end())
+    {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "include/cef_browser.h"
+#include "include/cef_request_context.h"
+
+// Request contexts (profiles) of the browsers. On-disk profiles live below
+// the root cache path that initCef hands to CEF, since CEF refuses cache
+// paths outside of it.
+namespace request_contexts
+{
+  void SetRootCachePath(const std::string &path);
+
+  const std::string &RootCachePath();
+
+  // Cache path of the context used by browsers created afterwards, relative
+  // paths are resolved against the root cache path. An empty path selects
+  // CEF's global context again.
+  void SetDefaultCachePath(const std::string &path);
+
+  // Returns the context for new browsers, nullptr for the global one. Must
+  // be called on the UI thread.
+  CefRefPtr<CefRequestContext> GetDefault();
+
+  // Returns the context shared by all browsers created with |key| and keeps
+  // it for a browser about to be created. Contexts of different keys have
+  // separate cookies, storage and caches, kept on disk below the root cache
+  // path if |persistent| and in memory otherwise. A key keeps the storage it
+  // was first created with. The empty key is the default context. Must be
+  // called on the UI thread.
+  CefRefPtr<CefRequestContext> Acquire(const std::string &key, bool persistent);
+
+  // Gives up the context kept by Acquire when the browser was not created.
+  void Cancel(const std::string &key);
+
+  // Counts the created |browser| for its pooled context, including hidden
+  // companions sharing it. Must be called on the UI thread.
+  void Attach(CefRefPtr<CefBrowser> browser);
+
+  // Drops the count of a closed browser, the context goes away with the last
+  // one. Must be called on the UI thread.
+  void Detach(int browser_id);
+
+  // Identifies the context of a browser passed to Attach, browsers sharing a
+  // context get the same id and 0 is CEF's global context. Callable on any
+  // thread.
+  std::optional<uint64_t> ContextId(int browser_id);
+}
@@ -0,0 +1,293 @@
+#include "resource_monitor.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
+#include "include/wrapper/cef_helpers.h"
+
+#include "simple_handler.h"
+
+namespace
+{
+  // Read utime + stime (fields 14 and 15) from /proc/<pid>/stat. The command
+  // name in field 2 may contain spaces, so parsing starts after the last ')'.
+  bool ReadCpuTicks(int pid, uint64_t &ticks)
+  {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string content;
+    if (!std::getline(file, content))
+    {
+      return false;
+    }
+    const auto pos = content.rfind(')');
+    if (pos == std::string::npos)
+    {
+      return false;
+    }
+    std::istringstream fields(content.substr(pos + 1));
+    std::string field;
+    uint64_t utime = 0;
+    uint64_t stime = 0;
+    // fields after the command name start at index 3 (state)
+    for (int index = 3; index <= 15 && fields >> field; index++)
+    {
+      if (index == 14)
+      {
+        utime = std::stoull(field);
+      }
+      else if (index == 15)
+      {
+        stime = std::stoull(field);
+      }
+    }
+    ticks = utime + stime;
+    return true;
+  }
+
+  bool ReadResidentBytes(int pid, int64_t &bytes)
+  {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/statm");
+    int64_t size = 0;
+    int64_t resident = 0;
+    if (!(file >> size >> resident))
+    {
+      return false;
+    }
+    bytes = resident * sysconf(_SC_PAGESIZE);
+    return true;
+  }
+
+  void RequestUsage()
+  {
+    CEF_REQUIRE_UI_THREAD();
+    auto handler = SimpleHandler::GetInstance();
+    if (handler)
+    {
+      handler->sampleUsage();
+    }
+  }
+}
+
+// static
+ResourceMonitor *ResourceMonitor::GetInstance()
+{
+  static ResourceMonitor instance;
+  return &instance;
+}
+
+ResourceMonitor::~ResourceMonitor()
+{
+  Stop();
+}
+
+void ResourceMonitor::SetInterval(int interval_ms)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interval_ms_ = interval_ms;
+  }
+  if (interval_ms > 0)
+  {
+    EnsureStarted();
+    cv_.notify_all();
+  }
+  else
+  {
+    Stop();
+  }
+}
+
+int ResourceMonitor::GetInterval()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return interval_ms_;
+}
+
+void ResourceMonitor::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+void ResourceMonitor::Register(int64_t texture_id, int renderer_pid)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = entries_[texture_id];
+    if (entry.usage.renderer_pid != renderer_pid)
+    {
+      // browser moved to another renderer (e.g. cross-site navigation)
+      entry = Entry();
+      entry.usage.renderer_pid = renderer_pid;
+    }
+  }
+  EnsureStarted();
+}
+
+void ResourceMonitor::Unregister(int64_t texture_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.erase(texture_id);
+}
+
+void ResourceMonitor::SetHeapUsage(int64_t texture_id, int64_t used, int64_t total)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(texture_id);
+  if (it != entries_.end())
+  {
+    it->second.usage.js_heap_used = used;
+    it->second.usage.js_heap_total = total;
+  }
+}
+
+void ResourceMonitor::SetRasterPixels(int64_t texture_id, uint64_t pixels)
+{
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(texture_id);
+  if (it == entries_.end())
+  {
+    return;
+  }
+  auto &entry = it->second;
+  if (entry.last_raster_sample.time_since_epoch().count() > 0 && pixels >= entry.last_raster_pixels)
+  {
+    const double elapsed_s = std::chrono::duration<double>(now - entry.last_raster_sample).count();
+    if (elapsed_s > 0)
+    {
+      entry.usage.raster_pixels_per_second = (pixels - entry.last_raster_pixels) / elapsed_s;
+    }
+  }
+  entry.last_raster_pixels = pixels;
+  entry.last_raster_sample = now;
+}
+
+void ResourceMonitor::SetPerformanceMetrics(int64_t texture_id, std::optional<PerformanceMetrics> metrics)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(texture_id);
+  if (it != entries_.end())
+  {
+    it->second.usage.performance = metrics;
+    if (metrics)
+    {
+      it->second.usage.js_heap_used = metrics->js_heap_used;
+      it->second.usage.js_heap_total = metrics->js_heap_total;
+    }
+  }
+}
+
+std::optional<ResourceUsage> ResourceMonitor::GetUsage(int64_t texture_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(texture_id);
+  if (it == entries_.end())
+  {
+    return std::nullopt;
+  }
+  return it->second.usage;
+}
+
+void ResourceMonitor::EnsureStarted()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_ || interval_ms_ <= 0)
+  {
+    return;
+  }
+  if (thread_.joinable())
+  {
+    // previous sampler was asked to stop but not joined yet
+    return;
+  }
+  running_ = true;
+  thread_ = std::thread(&ResourceMonitor::Run, this);
+}
+
+void ResourceMonitor::Run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_)
+  {
+    lock.unlock();
+    Sample();
+    lock.lock();
+    cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_ > 0 ? interval_ms_ : 1000),
+                 [this]
+                 { return !running_; });
+  }
+}
+
+void ResourceMonitor::Sample()
+{
+  std::vector<std::pair<int64_t, int>> targets;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &[texture_id, entry] : entries_)
+    {
+      if (entry.usage.renderer_pid > 0)
+      {
+        targets.emplace_back(texture_id, entry.usage.renderer_pid);
+      }
+    }
+  }
+  if (targets.empty())
+  {
+    return;
+  }
+
+  static const double ms_per_tick = 1000.0 / sysconf(_SC_CLK_TCK);
+  const auto now = std::chrono::steady_clock::now();
+
+  for (const auto &[texture_id, pid] : targets)
+  {
+    uint64_t ticks = 0;
+    int64_t rss = 0;
+    const bool has_cpu = ReadCpuTicks(pid, ticks);
+    const bool has_rss = ReadResidentBytes(pid, rss);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(texture_id);
+    if (it == entries_.end() || it->second.usage.renderer_pid != pid)
+    {
+      continue;
+    }
+    auto &entry = it->second;
+    if (has_cpu)
+    {
+      if (entry.last_cpu_ticks > 0 && ticks >= entry.last_cpu_ticks)
+      {
+        const double elapsed_ms =
+            std::chrono::duration<double, std::milli>(now - entry.last_sample).count();
+        if (elapsed_ms > 0)
+        {
+          entry.usage.cpu_percent = (ticks - entry.last_cpu_ticks) * ms_per_tick * 100.0 / elapsed_ms;
+        }
+      }
+      entry.usage.cpu_time_ms = ticks * ms_per_tick;
+      entry.last_cpu_ticks = ticks;
+      entry.last_sample = now;
+    }
+    if (has_rss)
+    {
+      entry.usage.rss_bytes = rss;
+    }
+  }
+
+  // the js heap can only be queried through DevTools on the UI thread, the
+  // raster pixels are counted by the bridges there
+  CefPostTask(TID_UI, base::BindOnce(&RequestUsage));
+}
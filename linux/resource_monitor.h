@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Cumulative counters of the DevTools Performance domain, durations are
+// converted from seconds to milliseconds.
+struct PerformanceMetrics
+{
+  int64_t layout_count = 0;
+  int64_t recalc_style_count = 0;
+  double layout_duration_ms = 0;
+  double recalc_style_duration_ms = 0;
+  double script_duration_ms = 0;
+  double task_duration_ms = 0;
+  int64_t js_heap_used = 0;
+  int64_t js_heap_total = 0;
+  int64_t nodes = 0;
+};
+
+struct ResourceUsage
+{
+  int renderer_pid = 0;
+  // cumulative user + system cpu time of the renderer process
+  double cpu_time_ms = 0;
+  // share of one core used by the renderer during the last interval
+  double cpu_percent = 0;
+  int64_t rss_bytes = 0;
+  int64_t js_heap_used = 0;
+  int64_t js_heap_total = 0;
+  uint64_t paint_count = 0;
+  uint64_t paint_bytes = 0;
+  // dirty pixels painted per second during the last interval
+  double raster_pixels_per_second = 0;
+  // only filled in while performance metrics are collected for the browser
+  std::optional<PerformanceMetrics> performance;
+};
+
+// Samples renderer processes of registered browsers on a background thread.
+// Cpu time and rss come from /proc/<pid>, the js heap is filled in from the
+// UI thread when the DevTools result arrives. Paint counters are kept by the
+// bridges themselves and merged in on query, the raster rate is computed
+// from the counts they hand in at each interval.
+class ResourceMonitor
+{
+public:
+  static ResourceMonitor *GetInstance();
+
+  ~ResourceMonitor();
+
+  // Sampling interval in milliseconds, 0 stops the sampler thread. Off until
+  // enabled from Dart, heap sampling attaches DevTools to every browser.
+  void SetInterval(int interval_ms);
+
+  int GetInterval();
+
+  void Stop();
+
+  void Register(int64_t texture_id, int renderer_pid);
+
+  void Unregister(int64_t texture_id);
+
+  void SetHeapUsage(int64_t texture_id, int64_t used, int64_t total);
+
+  // Store the cumulative raster pixel count and update the rate since the
+  // previous one.
+  void SetRasterPixels(int64_t texture_id, uint64_t pixels);
+
+  // Store the latest metrics, std::nullopt once collection is turned off.
+  void SetPerformanceMetrics(int64_t texture_id, std::optional<PerformanceMetrics> metrics);
+
+  std::optional<ResourceUsage> GetUsage(int64_t texture_id);
+
+private:
+  ResourceMonitor() = default;
+
+  struct Entry
+  {
+    ResourceUsage usage;
+    uint64_t last_cpu_ticks = 0;
+    std::chrono::steady_clock::time_point last_sample;
+    uint64_t last_raster_pixels = 0;
+    std::chrono::steady_clock::time_point last_raster_sample;
+  };
+
+  void EnsureStarted();
+
+  void Run();
+
+  void Sample();
+
+  std::mutex mutex_;
+
+  std::condition_variable cv_;
+
+  std::thread thread_;
+
+  bool running_ = false;
+
+  int interval_ms_ = 0;
+
+  // Map of texture id -> sampled usage
+  std::map<int64_t, Entry> entries_;
+};
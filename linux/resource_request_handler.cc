@@ -0,0 +1,89 @@
+#include "resource_request_handler.h"
+
+#include "load_policy.h"
+#include "network_timing.h"
+#include "request_blocker.h"
+#include "response_cache.h"
+
+CefResourceRequestHandler::ReturnValue ResourceRequestHandler::OnBeforeResourceLoad(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request,
+    CefRefPtr<CefCallback> callback)
+{
+  // service worker requests have no browser
+  if (!browser)
+  {
+    return RV_CONTINUE;
+  }
+  const cef_resource_type_t type = request->GetResourceType();
+  std::string first_party;
+  if (type != RT_MAIN_FRAME)
+  {
+    CefRefPtr<CefFrame> main_frame = browser->GetMainFrame();
+    if (main_frame)
+    {
+      first_party = main_frame->GetURL();
+    }
+  }
+  const std::string url = request->GetURL();
+  if (request_blocker::Registry::GetInstance()->ShouldBlock(
+          browser->GetIdentifier(), url, first_party, type))
+  {
+    return RV_CANCEL;
+  }
+  network_timing::Registry::GetInstance()->OnRequestStart(browser->GetIdentifier(), request);
+  return load_policy::Registry::GetInstance()->OnBeforeResourceLoad(
+      browser->GetIdentifier(), request, request_blocker::IsThirdParty(url, first_party), callback);
+}
+
+CefRefPtr<CefResourceHandler> ResourceRequestHandler::GetResourceHandler(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request)
+{
+  return response_cache::GetResourceHandler(browser, request);
+}
+
+bool ResourceRequestHandler::OnResourceResponse(CefRefPtr<CefBrowser> browser,
+                                                CefRefPtr<CefFrame> frame,
+                                                CefRefPtr<CefRequest> request,
+                                                CefRefPtr<CefResponse> response)
+{
+  if (browser)
+  {
+    network_timing::Registry::GetInstance()->OnResponseStart(browser->GetIdentifier(), request, response);
+  }
+  return false;
+}
+
+CefRefPtr<CefResponseFilter> ResourceRequestHandler::GetResourceResponseFilter(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request,
+    CefRefPtr<CefResponse> response)
+{
+  if (!browser)
+  {
+    return nullptr;
+  }
+  return load_policy::Registry::GetInstance()->GetResponseFilter(browser->GetIdentifier(), request, response);
+}
+
+void ResourceRequestHandler::OnResourceLoadComplete(CefRefPtr<CefBrowser> browser,
+                                                    CefRefPtr<CefFrame> frame,
+                                                    CefRefPtr<CefRequest> request,
+                                                    CefRefPtr<CefResponse> response,
+                                                    URLRequestStatus status,
+                                                    int64 received_content_length)
+{
+  if (browser)
+  {
+    network_timing::Registry::GetInstance()->OnRequestComplete(
+        browser->GetIdentifier(), request, response, status, received_content_length);
+  }
+  if (status == UR_SUCCESS)
+  {
+    request_blocker::Registry::GetInstance()->OnResponseSize(request->GetResourceType(), received_content_length);
+  }
+}
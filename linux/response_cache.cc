@@ -0,0 +1,815 @@
+#include "response_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "include/cef_request_context.h"
+#include "include/cef_urlrequest.h"
+
+#include "request_contexts.h"
+#include "response_store.h"
+
+namespace response_cache
+{
+  namespace
+  {
+    // fetches stop at redirects, the browser follows them itself
+    bool IsRedirect(int status)
+    {
+      return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+    }
+
+    RequestHeaders LowerCaseHeaders(const CefRequest::HeaderMap &headers)
+    {
+      RequestHeaders lower;
+      for (const auto &[name, value] : headers)
+      {
+        lower.emplace(ToLower(name.ToString()), value.ToString());
+      }
+      return lower;
+    }
+
+    // Reads status, headers and caching rules of a response whose body is
+    // about to arrive. Only bodies of a known length below |max_body_bytes|
+    // are kept to be stored or shared.
+    std::shared_ptr<Response> ReadHead(CefRefPtr<CefResponse> source,
+                                       const RequestHeaders &request_headers,
+                                       int64_t max_body_bytes)
+    {
+      auto response = std::make_shared<Response>();
+      response->status = source->GetStatus();
+      response->status_text = source->GetStatusText();
+      response->mime_type = source->GetMimeType();
+      response->charset = source->GetCharset();
+      CefResponse::HeaderMap headers;
+      source->GetHeaderMap(headers);
+      // the body arrives decoded
+      for (const auto &[name, value] : headers)
+      {
+        const std::string lower = ToLower(name.ToString());
+        if (lower != "content-encoding" && lower != "content-length" && lower != "transfer-encoding")
+        {
+          response->headers.emplace_back(name.ToString(), value.ToString());
+        }
+      }
+
+      const Directives directives = ParseCacheControl(source->GetHeaderByName("Cache-Control"));
+      const std::vector<std::string> vary = SplitList(source->GetHeaderByName("Vary"));
+      const bool vary_all = std::find(vary.begin(), vary.end(), "*") != vary.end();
+      const bool sets_cookie = !source->GetHeaderByName("Set-Cookie").empty();
+      // streams never end and unknown lengths could be anything
+      const std::string length = source->GetHeaderByName("Content-Length");
+      const bool bounded = IsRedirect(response->status) ||
+                           (ToLower(response->mime_type) != "text/event-stream" && !length.empty() &&
+                            strtoll(length.c_str(), nullptr, 10) <= max_body_bytes);
+
+      // entries are shared by the browsers of a request context, like a proxy
+      response->shareable = bounded && !directives.no_store && !directives.is_private && !vary_all && !sets_cookie;
+      for (const auto &name : vary)
+      {
+        auto it = request_headers.find(name);
+        response->vary.emplace_back(name, it == request_headers.end() ? std::string() : it->second);
+      }
+
+      const int64_t lifetime = FreshnessLifetime(directives,
+                                                 source->GetHeaderByName("Expires"),
+                                                 source->GetHeaderByName("Date"),
+                                                 source->GetHeaderByName("Age"),
+                                                 std::time(nullptr));
+      response->storable = response->shareable && !directives.no_cache && response->status == 200 && lifetime > 0;
+      response->expires = Clock::now() + std::chrono::seconds(std::max<int64_t>(lifetime, 0));
+      return response;
+    }
+
+    class CachedResourceHandler;
+
+    class Cache
+    {
+    public:
+      static Cache &Get();
+
+      void Configure(Config config)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = std::move(config);
+        store_.Reset(config_.max_bytes);
+      }
+
+      Stats GetStats()
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats = stats_;
+        stats.evictions = store_.evictions();
+        stats.entries = store_.entries();
+        stats.bytes = store_.bytes();
+        return stats;
+      }
+
+      // Only urls below one of the configured prefixes are cached.
+      bool Matches(const std::string &url)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (config_.max_bytes <= 0)
+        {
+          return false;
+        }
+        return std::any_of(config_.url_prefixes.begin(), config_.url_prefixes.end(),
+                           [&url](const std::string &prefix)
+                           { return !prefix.empty() && url.compare(0, prefix.size(), prefix) == 0; });
+      }
+
+      // Returns a fresh response for the request or nullptr.
+      ResponseRef Lookup(const std::string &key, const RequestHeaders &headers)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ResponseRef found = store_.Lookup(key, headers, Clock::now());
+        if (found)
+        {
+          stats_.hits++;
+        }
+        return found;
+      }
+
+      // Adds |handler| to the running fetch of its key, or starts a fetch if
+      // there is none or |join| is false.
+      void Fetch(CefRefPtr<CachedResourceHandler> handler, bool join);
+
+      // Drops a cancelled request, the fetch stops with its last request.
+      void Leave(CachedResourceHandler *handler);
+
+      // The head of a response arrived, it is streamed to the request the
+      // fetch was made for. Requests that joined are sent to fetches of
+      // their own unless the body may be shared.
+      void OnFetchHead(uint64_t flight_id, ResponseRef head);
+
+      void OnFetchData(uint64_t flight_id, const char *data, size_t length);
+
+      // The body turned out larger than its Content-Length promised.
+      void OnFetchUnshared(uint64_t flight_id);
+
+      void OnFetchComplete(uint64_t flight_id, ResponseRef response);
+
+    private:
+      struct Waiter
+      {
+        CefRefPtr<CachedResourceHandler> handler;
+        // false for the request the fetch was made for
+        bool joined;
+      };
+
+      struct Flight
+      {
+        std::string key;
+        std::vector<Waiter> waiters;
+        CefRefPtr<CefURLRequest> url_request;
+        // whether the request the fetch was made for got the head
+        bool streaming = false;
+      };
+
+      // Takes the joined requests out of a fetch they may not share and
+      // keeps new requests from joining it. |mutex_| must be held.
+      std::vector<Waiter> Unshare(uint64_t flight_id, Flight &flight);
+
+      // Puts |waiters| on fetches of their own.
+      void Refetch(std::vector<Waiter> waiters);
+
+      std::mutex mutex_;
+      Config config_;
+      Stats stats_;
+      Store store_;
+
+      // Map of flight id -> running fetch
+      std::map<uint64_t, Flight> flights_;
+
+      // Map of key -> flight new requests may join
+      std::unordered_map<std::string, uint64_t> joinable_;
+
+      uint64_t next_flight_id_ = 1;
+    };
+
+    // Streams the response of a fetch started by the cache to the request it
+    // was made for and collects bounded bodies for the cache. Its callbacks
+    // run on the IO thread that started the fetch.
+    class FetchClient : public CefURLRequestClient
+    {
+    public:
+      FetchClient(uint64_t flight_id, RequestHeaders request_headers, int64_t max_body_bytes)
+          : flight_id_(flight_id),
+            request_headers_(std::move(request_headers)),
+            max_body_bytes_(max_body_bytes) {}
+
+      void OnRequestComplete(CefRefPtr<CefURLRequest> request) override
+      {
+        CheckHead(request);
+        std::shared_ptr<Response> response;
+        if (head_)
+        {
+          response = std::make_shared<Response>(*head_);
+          // a fetch stopped at a redirect counts as cancelled
+          if (request->GetRequestStatus() != UR_SUCCESS && !IsRedirect(head_->status))
+          {
+            response->error = request->GetRequestError() != ERR_NONE ? request->GetRequestError() : ERR_FAILED;
+            response->storable = false;
+          }
+          response->body = std::move(body_);
+          if (!shared_)
+          {
+            response->shareable = false;
+            response->storable = false;
+          }
+        }
+        else
+        {
+          response = std::make_shared<Response>();
+          response->error = request->GetRequestError() != ERR_NONE ? request->GetRequestError() : ERR_FAILED;
+          // a failing backend fails every waiting request once
+          response->shareable = true;
+        }
+        Cache::Get().OnFetchComplete(flight_id_, std::move(response));
+      }
+
+      void OnUploadProgress(CefRefPtr<CefURLRequest> request, int64 current, int64 total) override {}
+
+      void OnDownloadProgress(CefRefPtr<CefURLRequest> request, int64 current, int64 total) override
+      {
+        CheckHead(request);
+      }
+
+      void OnDownloadData(CefRefPtr<CefURLRequest> request, const void *data, size_t data_length) override
+      {
+        CheckHead(request);
+        if (shared_)
+        {
+          body_.append(static_cast<const char *>(data), data_length);
+          if (static_cast<int64_t>(body_.size()) > max_body_bytes_)
+          {
+            shared_ = false;
+            std::string().swap(body_);
+            Cache::Get().OnFetchUnshared(flight_id_);
+          }
+        }
+        Cache::Get().OnFetchData(flight_id_, static_cast<const char *>(data), data_length);
+      }
+
+      bool GetAuthCredentials(bool isProxy,
+                              const CefString &host,
+                              int port,
+                              const CefString &realm,
+                              const CefString &scheme,
+                              CefRefPtr<CefAuthCallback> callback) override
+      {
+        return false;
+      }
+
+    private:
+      void CheckHead(CefRefPtr<CefURLRequest> request)
+      {
+        if (head_)
+        {
+          return;
+        }
+        CefRefPtr<CefResponse> source = request->GetResponse();
+        if (!source || source->GetStatus() == 0)
+        {
+          return;
+        }
+        std::shared_ptr<Response> head = ReadHead(source, request_headers_, max_body_bytes_);
+        shared_ = head->shareable;
+        head_ = head;
+        Cache::Get().OnFetchHead(flight_id_, std::move(head));
+      }
+
+      const uint64_t flight_id_;
+      const RequestHeaders request_headers_;
+      const int64_t max_body_bytes_;
+      ResponseRef head_;
+      // whether the body is collected for requests that joined or the store
+      bool shared_ = false;
+      std::string body_;
+
+      IMPLEMENT_REFCOUNTING(FetchClient);
+    };
+
+    // Answers one request from a cached response, a fetch it joined or one
+    // streamed from the network. Everything but construction runs on the IO
+    // thread.
+    class CachedResourceHandler : public CefResourceHandler
+    {
+    public:
+      CachedResourceHandler(CefRefPtr<CefRequest> request, CefRefPtr<CefRequestContext> context, std::string key)
+          : key_(std::move(key)),
+            url_(request->GetURL()),
+            referrer_url_(request->GetReferrerURL()),
+            referrer_policy_(request->GetReferrerPolicy()),
+            first_party_(request->GetFirstPartyForCookies()),
+            context_(context)
+      {
+        request->GetHeaderMap(headers_);
+        lower_headers_ = LowerCaseHeaders(headers_);
+      }
+
+      const std::string &key() const { return key_; }
+
+      CefRefPtr<CefURLRequest> StartFetch(uint64_t flight_id, int64_t max_body_bytes)
+      {
+        CefRefPtr<CefRequest> fetch = CefRequest::Create();
+        fetch->SetURL(url_);
+        fetch->SetMethod("GET");
+        fetch->SetHeaderMap(headers_);
+        fetch->SetReferrer(referrer_url_, referrer_policy_);
+        fetch->SetFirstPartyForCookies(first_party_);
+        fetch->SetFlags(UR_FLAG_ALLOW_STORED_CREDENTIALS | UR_FLAG_STOP_ON_REDIRECT);
+        return CefURLRequest::Create(fetch, new FetchClient(flight_id, lower_headers_, max_body_bytes), context_);
+      }
+
+      // A complete response, for requests that joined a fetch or when the
+      // fetch failed before a head arrived.
+      void OnFetched(ResponseRef response, bool joined)
+      {
+        if (!callback_)
+        {
+          return;
+        }
+        if (joined && (!response->shareable || !VaryMatches(*response, lower_headers_)))
+        {
+          // not meant for this request after all
+          Cache::Get().Fetch(this, false);
+          return;
+        }
+        response_ = std::move(response);
+        CefRefPtr<CefCallback> callback = std::move(callback_);
+        callback->Continue();
+      }
+
+      // The head of the fetch made for this request, the body follows with
+      // OnData.
+      void OnHead(ResponseRef head)
+      {
+        if (!callback_)
+        {
+          return;
+        }
+        response_ = std::move(head);
+        streaming_ = true;
+        CefRefPtr<CefCallback> callback = std::move(callback_);
+        callback->Continue();
+      }
+
+      void OnData(const char *data, size_t length)
+      {
+        if (!streaming_ || done_)
+        {
+          return;
+        }
+        pending_.append(data, length);
+        if (read_callback_)
+        {
+          const int count = TakePending(read_buffer_, read_size_);
+          read_buffer_ = nullptr;
+          CefRefPtr<CefResourceReadCallback> callback = std::move(read_callback_);
+          callback->Continue(count);
+        }
+      }
+
+      void OnStreamComplete(cef_errorcode_t error)
+      {
+        if (!streaming_ || done_)
+        {
+          return;
+        }
+        done_ = true;
+        error_ = error;
+        if (read_callback_)
+        {
+          read_buffer_ = nullptr;
+          CefRefPtr<CefResourceReadCallback> callback = std::move(read_callback_);
+          callback->Continue(error_ != ERR_NONE ? error_ : 0);
+        }
+      }
+
+      bool Open(CefRefPtr<CefRequest> request,
+                bool &handle_request,
+                CefRefPtr<CefCallback> callback) override
+      {
+        response_ = Cache::Get().Lookup(key_, lower_headers_);
+        if (response_)
+        {
+          handle_request = true;
+          return true;
+        }
+        handle_request = false;
+        callback_ = callback;
+        Cache::Get().Fetch(this, true);
+        return true;
+      }
+
+      void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                              int64 &response_length,
+                              CefString &redirectUrl) override
+      {
+        if (response_->error != ERR_NONE)
+        {
+          response->SetError(response_->error);
+          response_length = 0;
+          return;
+        }
+        response->SetStatus(response_->status);
+        response->SetStatusText(response_->status_text);
+        response->SetMimeType(response_->mime_type);
+        response->SetCharset(response_->charset);
+        CefResponse::HeaderMap headers;
+        for (const auto &[name, value] : response_->headers)
+        {
+          headers.emplace(name, value);
+          if (IsRedirect(response_->status) && ToLower(name) == "location")
+          {
+            redirectUrl = value;
+          }
+        }
+        response->SetHeaderMap(headers);
+        response_length = streaming_ ? -1 : static_cast<int64>(response_->body.size());
+      }
+
+      bool Read(void *data_out,
+                int bytes_to_read,
+                int &bytes_read,
+                CefRefPtr<CefResourceReadCallback> callback) override
+      {
+        if (streaming_)
+        {
+          if (pending_offset_ < pending_.size())
+          {
+            bytes_read = TakePending(data_out, bytes_to_read);
+            return true;
+          }
+          if (done_)
+          {
+            bytes_read = error_ != ERR_NONE ? error_ : 0;
+            return false;
+          }
+          // continued once more of the body arrived
+          read_buffer_ = data_out;
+          read_size_ = bytes_to_read;
+          read_callback_ = callback;
+          bytes_read = 0;
+          return true;
+        }
+        const size_t remaining = response_->body.size() - offset_;
+        if (remaining == 0)
+        {
+          bytes_read = 0;
+          return false;
+        }
+        const size_t count = std::min(remaining, static_cast<size_t>(bytes_to_read));
+        memcpy(data_out, response_->body.data() + offset_, count);
+        offset_ += count;
+        bytes_read = static_cast<int>(count);
+        return true;
+      }
+
+      void Cancel() override
+      {
+        read_callback_ = nullptr;
+        read_buffer_ = nullptr;
+        if (callback_ || (streaming_ && !done_))
+        {
+          callback_ = nullptr;
+          done_ = true;
+          Cache::Get().Leave(this);
+        }
+      }
+
+    private:
+      int TakePending(void *data_out, int bytes_to_read)
+      {
+        const size_t count = std::min(pending_.size() - pending_offset_, static_cast<size_t>(bytes_to_read));
+        memcpy(data_out, pending_.data() + pending_offset_, count);
+        pending_offset_ += count;
+        if (pending_offset_ == pending_.size())
+        {
+          pending_.clear();
+          pending_offset_ = 0;
+        }
+        return static_cast<int>(count);
+      }
+
+      const std::string key_;
+      const std::string url_;
+      const CefString referrer_url_;
+      const cef_referrer_policy_t referrer_policy_;
+      const CefString first_party_;
+      CefRefPtr<CefRequestContext> context_;
+      CefRequest::HeaderMap headers_;
+      RequestHeaders lower_headers_;
+
+      // set while waiting for a response or its head
+      CefRefPtr<CefCallback> callback_;
+      ResponseRef response_;
+      size_t offset_ = 0;
+
+      // the body of a streamed response as it arrives
+      bool streaming_ = false;
+      bool done_ = false;
+      cef_errorcode_t error_ = ERR_NONE;
+      std::string pending_;
+      size_t pending_offset_ = 0;
+
+      // set while Read waits for more of a streamed body
+      CefRefPtr<CefResourceReadCallback> read_callback_;
+      void *read_buffer_ = nullptr;
+      int read_size_ = 0;
+
+      IMPLEMENT_REFCOUNTING(CachedResourceHandler);
+      DISALLOW_COPY_AND_ASSIGN(CachedResourceHandler);
+    };
+
+    // static
+    Cache &Cache::Get()
+    {
+      static Cache cache;
+      return cache;
+    }
+
+    void Cache::Fetch(CefRefPtr<CachedResourceHandler> handler, bool join)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (join)
+      {
+        auto joinable = joinable_.find(handler->key());
+        if (joinable != joinable_.end())
+        {
+          flights_[joinable->second].waiters.push_back({handler, true});
+          stats_.coalesced++;
+          return;
+        }
+      }
+      const uint64_t flight_id = next_flight_id_++;
+      Flight &flight = flights_[flight_id];
+      flight.key = handler->key();
+      flight.waiters.push_back({handler, false});
+      if (join)
+      {
+        joinable_[flight.key] = flight_id;
+      }
+      stats_.misses++;
+      const int64_t max_body_bytes = store_.MaxEntryBytes();
+      lock.unlock();
+
+      // the client may complete right away, e.g. for an invalid url
+      CefRefPtr<CefURLRequest> url_request = handler->StartFetch(flight_id, max_body_bytes);
+      lock.lock();
+      auto it = flights_.find(flight_id);
+      if (it != flights_.end())
+      {
+        it->second.url_request = url_request;
+      }
+    }
+
+    void Cache::Leave(CachedResourceHandler *handler)
+    {
+      CefRefPtr<CefURLRequest> abandoned;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = flights_.begin(); it != flights_.end(); ++it)
+        {
+          auto &waiters = it->second.waiters;
+          auto waiter = std::find_if(waiters.begin(), waiters.end(),
+                                     [handler](const Waiter &item)
+                                     { return item.handler.get() == handler; });
+          if (waiter == waiters.end())
+          {
+            continue;
+          }
+          waiters.erase(waiter);
+          if (waiters.empty())
+          {
+            abandoned = it->second.url_request;
+            auto joinable = joinable_.find(it->second.key);
+            if (joinable != joinable_.end() && joinable->second == it->first)
+            {
+              joinable_.erase(joinable);
+            }
+            flights_.erase(it);
+          }
+          break;
+        }
+      }
+      if (abandoned)
+      {
+        abandoned->Cancel();
+      }
+    }
+
+    std::vector<Cache::Waiter> Cache::Unshare(uint64_t flight_id, Flight &flight)
+    {
+      auto joinable = joinable_.find(flight.key);
+      if (joinable != joinable_.end() && joinable->second == flight_id)
+      {
+        joinable_.erase(joinable);
+      }
+      std::vector<Waiter> joined;
+      auto first = std::stable_partition(flight.waiters.begin(), flight.waiters.end(),
+                                         [](const Waiter &waiter)
+                                         { return !waiter.joined; });
+      std::move(first, flight.waiters.end(), std::back_inserter(joined));
+      flight.waiters.erase(first, flight.waiters.end());
+      return joined;
+    }
+
+    void Cache::Refetch(std::vector<Waiter> waiters)
+    {
+      for (auto &waiter : waiters)
+      {
+        Fetch(waiter.handler, false);
+      }
+    }
+
+    void Cache::OnFetchHead(uint64_t flight_id, ResponseRef head)
+    {
+      CefRefPtr<CachedResourceHandler> origin;
+      std::vector<Waiter> unshared;
+      CefRefPtr<CefURLRequest> abandoned;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(flight_id);
+        if (it == flights_.end())
+        {
+          return;
+        }
+        Flight &flight = it->second;
+        if (!head->shareable)
+        {
+          unshared = Unshare(flight_id, flight);
+        }
+        for (const auto &waiter : flight.waiters)
+        {
+          if (!waiter.joined)
+          {
+            origin = waiter.handler;
+            flight.streaming = true;
+          }
+        }
+        if (flight.waiters.empty())
+        {
+          abandoned = flight.url_request;
+          flights_.erase(it);
+        }
+      }
+      if (abandoned)
+      {
+        abandoned->Cancel();
+      }
+      if (origin)
+      {
+        origin->OnHead(std::move(head));
+      }
+      Refetch(std::move(unshared));
+    }
+
+    void Cache::OnFetchData(uint64_t flight_id, const char *data, size_t length)
+    {
+      CefRefPtr<CachedResourceHandler> origin;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(flight_id);
+        if (it == flights_.end() || !it->second.streaming)
+        {
+          return;
+        }
+        for (const auto &waiter : it->second.waiters)
+        {
+          if (!waiter.joined)
+          {
+            origin = waiter.handler;
+          }
+        }
+      }
+      if (origin)
+      {
+        origin->OnData(data, length);
+      }
+    }
+
+    void Cache::OnFetchUnshared(uint64_t flight_id)
+    {
+      std::vector<Waiter> unshared;
+      CefRefPtr<CefURLRequest> abandoned;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(flight_id);
+        if (it == flights_.end())
+        {
+          return;
+        }
+        unshared = Unshare(flight_id, it->second);
+        if (it->second.waiters.empty())
+        {
+          abandoned = it->second.url_request;
+          flights_.erase(it);
+        }
+      }
+      if (abandoned)
+      {
+        abandoned->Cancel();
+      }
+      Refetch(std::move(unshared));
+    }
+
+    void Cache::OnFetchComplete(uint64_t flight_id, ResponseRef response)
+    {
+      std::vector<Waiter> waiters;
+      bool streaming;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = flights_.find(flight_id);
+        if (it == flights_.end())
+        {
+          // every request was cancelled
+          return;
+        }
+        waiters = std::move(it->second.waiters);
+        streaming = it->second.streaming;
+        auto joinable = joinable_.find(it->second.key);
+        if (joinable != joinable_.end() && joinable->second == flight_id)
+        {
+          joinable_.erase(joinable);
+        }
+        if (response->storable)
+        {
+          store_.Insert(it->second.key, response);
+        }
+        flights_.erase(it);
+      }
+      for (auto &waiter : waiters)
+      {
+        if (!waiter.joined && streaming)
+        {
+          waiter.handler->OnStreamComplete(response->error);
+        }
+        else
+        {
+          waiter.handler->OnFetched(response, waiter.joined);
+        }
+      }
+    }
+  }
+
+  void Configure(Config config)
+  {
+    Cache::Get().Configure(std::move(config));
+  }
+
+  Stats GetStats()
+  {
+    return Cache::Get().GetStats();
+  }
+
+  CefRefPtr<CefResourceHandler> GetResourceHandler(CefRefPtr<CefBrowser> browser,
+                                                   CefRefPtr<CefRequest> request)
+  {
+    if (!browser || request->GetMethod() != "GET")
+    {
+      return nullptr;
+    }
+    switch (request->GetResourceType())
+    {
+    case RT_MAIN_FRAME:
+    case RT_SUB_FRAME:
+    case RT_MEDIA:
+      return nullptr;
+    default:
+      break;
+    }
+    const std::string url = request->GetURL();
+    if (!Cache::Get().Matches(url))
+    {
+      return nullptr;
+    }
+    // reloads, explicit bypasses, credentials and event streams go to the
+    // network
+    const Directives directives = ParseCacheControl(request->GetHeaderByName("Cache-Control"));
+    if (directives.no_store || directives.no_cache ||
+        ToLower(request->GetHeaderByName("Pragma")) == "no-cache" ||
+        !request->GetHeaderByName("Range").empty() ||
+        !request->GetHeaderByName("Authorization").empty() ||
+        ToLower(request->GetHeaderByName("Accept")).find("text/event-stream") != std::string::npos)
+    {
+      return nullptr;
+    }
+    // cookies and cached responses stay within a request context
+    const auto context_id = request_contexts::ContextId(browser->GetIdentifier());
+    if (!context_id)
+    {
+      return nullptr;
+    }
+    return new CachedResourceHandler(request, browser->GetHost()->GetRequestContext(),
+                                     std::to_string(*context_id) + " " + url);
+  }
+}
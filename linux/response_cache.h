@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "include/cef_browser.h"
+#include "include/cef_request.h"
+#include "include/cef_resource_handler.h"
+
+// In-process cache for the API endpoints many browsers poll, shared by the
+// browsers of a request context. Matching GET requests are answered by
+// ResourceRequestHandler from memory while the response is fresh per
+// Cache-Control, Expires and Vary. Concurrent misses for the same url wait
+// for a single fetch and the least recently used responses are evicted above
+// the memory cap. Stale responses are fetched again, there is no
+// revalidation. Requests with credentials, event streams, bodies without a
+// length or above a quarter of the cap and redirects pass through.
+namespace response_cache
+{
+  struct Config
+  {
+    // 0 disables the cache
+    int64_t max_bytes = 0;
+    // only urls starting with one of these are cached, none if empty
+    std::vector<std::string> url_prefixes;
+  };
+
+  struct Stats
+  {
+    uint64_t hits = 0;
+    // fetches started for a request
+    uint64_t misses = 0;
+    // requests answered by a fetch another request started
+    uint64_t coalesced = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    int64_t bytes = 0;
+  };
+
+  // Replaces the configuration and drops all cached responses.
+  void Configure(Config config);
+
+  Stats GetStats();
+
+  // Returns the handler answering |request| from the cache or a shared fetch,
+  // nullptr to let the network service load it. Called on the IO thread.
+  CefRefPtr<CefResourceHandler> GetResourceHandler(CefRefPtr<CefBrowser> browser,
+                                                   CefRefPtr<CefRequest> request);
+}
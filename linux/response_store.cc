@@ -0,0 +1,204 @@
+#include "response_store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+namespace response_cache
+{
+  namespace
+  {
+    std::string Trim(const std::string &value)
+    {
+      const auto begin = value.find_first_not_of(" \t\r");
+      if (begin == std::string::npos)
+      {
+        return "";
+      }
+      const auto end = value.find_last_not_of(" \t\r");
+      return value.substr(begin, end - begin + 1);
+    }
+  }
+
+  std::string ToLower(std::string value)
+  {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c)
+                   { return std::tolower(c); });
+    return value;
+  }
+
+  std::vector<std::string> SplitList(const std::string &value)
+  {
+    std::vector<std::string> items;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+      item = ToLower(Trim(item));
+      if (!item.empty())
+      {
+        items.push_back(item);
+      }
+    }
+    return items;
+  }
+
+  Directives ParseCacheControl(const std::string &value)
+  {
+    Directives directives;
+    for (const auto &item : SplitList(value))
+    {
+      const auto equals = item.find('=');
+      const std::string name = Trim(item.substr(0, equals));
+      std::string argument = equals == std::string::npos ? "" : Trim(item.substr(equals + 1));
+      if (argument.size() >= 2 && argument.front() == '"' && argument.back() == '"')
+      {
+        argument = argument.substr(1, argument.size() - 2);
+      }
+      if (name == "no-store")
+      {
+        directives.no_store = true;
+      }
+      else if (name == "no-cache")
+      {
+        directives.no_cache = true;
+      }
+      else if (name == "private")
+      {
+        directives.is_private = true;
+      }
+      else if (name == "max-age")
+      {
+        directives.max_age = strtoll(argument.c_str(), nullptr, 10);
+      }
+      else if (name == "s-maxage")
+      {
+        directives.s_maxage = strtoll(argument.c_str(), nullptr, 10);
+      }
+    }
+    return directives;
+  }
+
+  bool ParseHttpDate(const std::string &value, time_t &time)
+  {
+    struct tm parsed = {};
+    if (!strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S", &parsed))
+    {
+      return false;
+    }
+    time = timegm(&parsed);
+    return true;
+  }
+
+  int64_t FreshnessLifetime(const Directives &directives,
+                            const std::string &expires,
+                            const std::string &date,
+                            const std::string &age,
+                            time_t now)
+  {
+    int64_t lifetime = directives.s_maxage >= 0 ? directives.s_maxage : directives.max_age;
+    if (lifetime < 0)
+    {
+      time_t expires_time = 0;
+      time_t date_time = 0;
+      if (!ParseHttpDate(expires, expires_time))
+      {
+        // no explicit lifetime, nothing is guessed from Last-Modified
+        return 0;
+      }
+      lifetime = expires_time - (ParseHttpDate(date, date_time) ? date_time : now);
+    }
+    return lifetime - std::max<int64_t>(strtoll(age.c_str(), nullptr, 10), 0);
+  }
+
+  bool VaryMatches(const Response &response, const RequestHeaders &headers)
+  {
+    for (const auto &[name, value] : response.vary)
+    {
+      auto it = headers.find(name);
+      if ((it == headers.end() ? std::string() : it->second) != value)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Store::Reset(int64_t max_bytes)
+  {
+    max_bytes_ = std::max<int64_t>(max_bytes, 0);
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  ResponseRef Store::Lookup(const std::string &key, const RequestHeaders &headers, Clock::time_point now)
+  {
+    ResponseRef found;
+    std::vector<std::list<Stored>::iterator> expired;
+    auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      const ResponseRef &response = it->second->response;
+      if (now >= response->expires)
+      {
+        expired.push_back(it->second);
+      }
+      else if (!found && VaryMatches(*response, headers))
+      {
+        found = response;
+        lru_.splice(lru_.begin(), lru_, it->second);
+      }
+    }
+    for (auto stored : expired)
+    {
+      Erase(stored);
+    }
+    return found;
+  }
+
+  bool Store::Insert(const std::string &key, ResponseRef response)
+  {
+    const int64_t size = response->Size();
+    if (size > MaxEntryBytes())
+    {
+      return false;
+    }
+    // replace the entry of the same variant
+    auto range = index_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second->response->vary == response->vary)
+      {
+        Erase(it->second);
+        break;
+      }
+    }
+    lru_.push_front({key, std::move(response)});
+    index_.emplace(key, lru_.begin());
+    bytes_ += size;
+    while (bytes_ > max_bytes_ && !lru_.empty())
+    {
+      Erase(std::prev(lru_.end()));
+      evictions_++;
+    }
+    return true;
+  }
+
+  void Store::Erase(std::list<Stored>::iterator stored)
+  {
+    auto range = index_.equal_range(stored->key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == stored)
+      {
+        index_.erase(it);
+        break;
+      }
+    }
+    bytes_ -= stored->response->Size();
+    lru_.erase(stored);
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "include/internal/cef_types.h"
+
+// HTTP freshness rules and the memory bounded store of response_cache, apart
+// from the CEF handlers. The store is not thread safe, the cache locks
+// around it.
+namespace response_cache
+{
+  using Clock = std::chrono::steady_clock;
+
+  // Header name and value pairs in the order they arrived
+  using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+  // Map of lower case name -> request header value
+  using RequestHeaders = std::map<std::string, std::string>;
+
+  struct Directives
+  {
+    bool no_store = false;
+    bool no_cache = false;
+    bool is_private = false;
+    int64_t max_age = -1;
+    int64_t s_maxage = -1;
+  };
+
+  Directives ParseCacheControl(const std::string &value);
+
+  // Parses an IMF-fixdate like "Sun, 06 Nov 1994 08:49:37 GMT".
+  bool ParseHttpDate(const std::string &value, time_t &time);
+
+  // Seconds a response stays fresh from s-maxage, max-age or Expires less
+  // its Date, minus the Age it had on arrival. Zero or less if it may not be
+  // reused. |now| stands in for a missing or invalid Date.
+  int64_t FreshnessLifetime(const Directives &directives,
+                            const std::string &expires,
+                            const std::string &date,
+                            const std::string &age,
+                            time_t now);
+
+  std::string ToLower(std::string value);
+
+  // Lower case, trimmed and non-empty items of a comma separated header.
+  std::vector<std::string> SplitList(const std::string &value);
+
+  struct Response
+  {
+    cef_errorcode_t error = ERR_NONE;
+    int status = 0;
+    std::string status_text;
+    std::string mime_type;
+    std::string charset;
+    HeaderList headers;
+    std::string body;
+    // lower case names from Vary with the request values it was fetched for
+    HeaderList vary;
+    Clock::time_point expires;
+    bool storable = false;
+    // whether requests that joined the fetch may be answered with it
+    bool shareable = false;
+
+    // body plus a rough cost of the status line, headers and bookkeeping
+    int64_t Size() const { return body.size() + 512; }
+  };
+
+  using ResponseRef = std::shared_ptr<const Response>;
+
+  bool VaryMatches(const Response &response, const RequestHeaders &headers);
+
+  // Fresh responses by key, the least recently used ones are evicted above
+  // the byte limit.
+  class Store
+  {
+  public:
+    // Drops all responses and sets the limit, 0 stores nothing.
+    void Reset(int64_t max_bytes);
+
+    // Largest response Insert accepts, a single one may use a quarter of the
+    // limit.
+    int64_t MaxEntryBytes() const { return max_bytes_ / 4; }
+
+    // Returns the variant of |key| matching |headers| that is fresh at
+    // |now|, nullptr if there is none. Expired variants are dropped.
+    ResponseRef Lookup(const std::string &key, const RequestHeaders &headers, Clock::time_point now);
+
+    // Adds |response| in place of the variant with the same Vary values,
+    // false if it is larger than MaxEntryBytes.
+    bool Insert(const std::string &key, ResponseRef response);
+
+    size_t entries() const { return lru_.size(); }
+
+    int64_t bytes() const { return bytes_; }
+
+    uint64_t evictions() const { return evictions_; }
+
+  private:
+    struct Stored
+    {
+      std::string key;
+      ResponseRef response;
+    };
+
+    void Erase(std::list<Stored>::iterator stored);
+
+    int64_t max_bytes_ = 0;
+    int64_t bytes_ = 0;
+    uint64_t evictions_ = 0;
+
+    // most recently used first
+    std::list<Stored> lru_;
+
+    // Map of key -> stored variants
+    std::unordered_multimap<std::string, std::list<Stored>::iterator> index_;
+  };
+}
@@ -8,12 +8,21 @@
 #include <iostream>
 
 #include "include/base/cef_callback.h"
+#include "include/base/cef_trace_event.h"
 #include "include/cef_app.h"
 #include "include/wrapper/cef_closure_task.h"
 #include "include/wrapper/cef_helpers.h"
 
+#include "load_policy.h"
+#include "network_timing.h"
 #include "renderer_delegate.h"
+#include "request_blocker.h"
+#include "request_contexts.h"
+#include "resource_monitor.h"
+#include "async_log.h"
+#include "cache_metrics.h"
 #include "data.h"
+#include "event_tracer.h"
 #include "webview.h"
 #include <fmt/core.h>
 
@@ -24,7 +33,7 @@ namespace
 } // namespace
 
 SimpleHandler::SimpleHandler()
-    : is_closing_(false)
+    : is_closing_(false), resource_request_handler_(new ResourceRequestHandler())
 {
   g_instance = this;
 }
@@ -43,7 +52,11 @@ SimpleHandler *SimpleHandler::GetInstance()
 void SimpleHandler::OnAfterCreated(CefRefPtr<CefBrowser> browser)
 {
   CEF_REQUIRE_UI_THREAD();
-  LOG(INFO) << "OnAfterCreated for browser " << browser->GetIdentifier();
+  EVENT_TRACE_SCOPE1(OnAfterCreated, browser->GetIdentifier());
+  ALOG(Info, "OnAfterCreated for browser {}", browser->GetIdentifier());
+  // attach before the first navigation to see all of its requests
+  cache_metrics::Attach(browser);
+  request_contexts::Attach(browser);
 }
 
 bool SimpleHandler::OnProcessMessageReceived(
@@ -52,17 +65,42 @@ bool SimpleHandler::OnProcessMessageReceived(
     CefProcessId source_process,
     CefRefPtr<CefProcessMessage> message)
 {
+  EVENT_TRACE_SCOPE1(OnProcessMessageReceived, browser->GetIdentifier());
   // Check the message name.
   const std::string &message_name = message->GetName();
-  LOG(INFO) << "recieved " << message_name << " message";
+  ALOG_EVERY_MS(Debug, 1000, "recieved {} message", message_name);
   if (message_name == client::renderer::kBrowserCreatedMessage)
   {
     int id = browser->GetIdentifier();
     int64_t texture_id = std::stoll(message->GetArgumentList()->GetString(0).ToString(), NULL, 10);
-    LOG(INFO) << "OnBrowserCreated for browser " << browser->GetIdentifier() << " with texture " << texture_id;
+    ALOG(Info, "OnBrowserCreated for browser {} with texture {}", browser->GetIdentifier(), texture_id);
+    const int renderer_pid = message->GetArgumentList()->GetSize() > 1 ? message->GetArgumentList()->GetInt(1) : 0;
+    auto prerendered = prerendered_.find(id);
+    if (prerendered != prerendered_.end())
+    {
+      prerendered->second.renderer_pid = renderer_pid;
+      return true;
+    }
+    if (cache_.count(id))
+    {
+      // a companion adopted before its renderer reported
+      if (renderer_pid > 0)
+      {
+        ResourceMonitor::GetInstance()->Register(texture_id, renderer_pid);
+      }
+      return true;
+    }
     cache_[id] = texture_id;
-    browser_list_[texture_id]->setBrowser(browser);
-    browser_list_[texture_id]->OnAfterCreated();
+    if (renderer_pid > 0)
+    {
+      ResourceMonitor::GetInstance()->Register(texture_id, renderer_pid);
+    }
+    auto bridge = getBridgeForTexture(texture_id);
+    if (bridge)
+    {
+      bridge->setBrowser(browser);
+      bridge->OnAfterCreated();
+    }
     return true;
   }
   else if (message_name == client::renderer::kWebMessage)
@@ -80,6 +118,11 @@ bool SimpleHandler::OnProcessMessageReceived(
     auto bridge = getBridge(browser->GetIdentifier());
     if (bridge)
     {
+      const int renderer_pid = message->GetArgumentList()->GetSize() > 0 ? message->GetArgumentList()->GetInt(0) : 0;
+      if (renderer_pid > 0)
+      {
+        ResourceMonitor::GetInstance()->Register(bridge->texture_id(), renderer_pid);
+      }
       bridge->browserEvent(WebviewEvent::JsContextCreated);
     }
   }
@@ -123,14 +166,20 @@ bool SimpleHandler::DoClose(CefRefPtr<CefBrowser> browser)
 void SimpleHandler::OnBeforeClose(CefRefPtr<CefBrowser> browser)
 {
   CEF_REQUIRE_UI_THREAD();
+  EVENT_TRACE_SCOPE1(OnBeforeClose, browser->GetIdentifier());
   auto bridge = getBridge(browser->GetIdentifier());
+  request_blocker::Registry::GetInstance()->Remove(browser->GetIdentifier());
+  load_policy::Registry::GetInstance()->Remove(browser->GetIdentifier());
+  network_timing::Registry::GetInstance()->Remove(browser->GetIdentifier());
+  cache_metrics::Detach(browser->GetIdentifier());
+  prerendered_.erase(browser->GetIdentifier());
+  // counted per browser, also closes without a bridge
+  request_contexts::Detach(browser->GetIdentifier());
 
   if (bridge)
   {
     cache_.erase(browser->GetIdentifier());
-    auto video_outlet_private =
-        get_video_outlet_private(bridge->texture_bridge);
-    browser_list_[video_outlet_private->texture_id]->resetBrowser();
+    bridge->resetBrowser();
     bridge->OnShutdown();
   }
 }
@@ -159,7 +208,7 @@ void SimpleHandler::OnLoadError(CefRefPtr<CefBrowser> browser,
 
 void SimpleHandler::CloseAllBrowsers(bool force_close)
 {
-  if (browser_list_.empty())
+  if (bridges().empty())
     return;
   if (!CefCurrentlyOn(TID_UI))
   {
@@ -168,10 +217,9 @@ void SimpleHandler::CloseAllBrowsers(bool force_close)
     return;
   }
 
-  for (const auto &[key, value] : browser_list_)
+  for (const auto &[key, value] : bridges())
   {
-
-    LOG(INFO) << "closing browser with texture " << key;
+    ALOG(Info, "closing browser with texture {}", key);
     value->closeBrowser(force_close);
   }
 }
@@ -182,10 +230,30 @@ void SimpleHandler::OnLoadingStateChange(CefRefPtr<CefBrowser> browser,
                                          bool canGoForward)
 {
   CEF_REQUIRE_UI_THREAD();
+  EVENT_TRACE_SCOPE1(OnLoadingStateChange, isLoading);
+  if (isLoading)
+  {
+    cache_metrics::OnLoadStart(browser->GetIdentifier());
+  }
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
     bridge->OnLoadingStateChange(isLoading, canGoBack, canGoForward);
+    if (!isLoading)
+    {
+      if (auto stats = cache_metrics::OnLoadEnd(browser->GetIdentifier()))
+      {
+        bridge->OnCacheStats(*stats);
+      }
+    }
+    // on navigation only the stragglers of earlier pages
+    if (auto pages = network_timing::Registry::GetInstance()->TakePages(browser->GetIdentifier(), isLoading))
+    {
+      for (const auto &page : *pages)
+      {
+        bridge->OnNetworkTiming(page);
+      }
+    }
   }
 }
 
@@ -198,6 +266,7 @@ void SimpleHandler::OnAddressChange(CefRefPtr<CefBrowser> browser,
                                     const CefString &url)
 {
   CEF_REQUIRE_UI_THREAD();
+  EVENT_TRACE_SCOPE1(OnAddressChange, browser->GetIdentifier());
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
@@ -209,7 +278,14 @@ void SimpleHandler::OnTitleChange(CefRefPtr<CefBrowser> browser,
                                   const CefString &title)
 {
   CEF_REQUIRE_UI_THREAD();
-  LOG(INFO) << "onTitleChange: " << title << " for browser " << browser->GetIdentifier();
+  EVENT_TRACE_SCOPE1(OnTitleChange, browser->GetIdentifier());
+  ALOG_EVERY_MS(Debug, 1000, "onTitleChange for browser {}", browser->GetIdentifier());
+  auto prerendered = prerendered_.find(browser->GetIdentifier());
+  if (prerendered != prerendered_.end())
+  {
+    prerendered->second.title = title;
+    return;
+  }
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
@@ -222,6 +298,7 @@ bool SimpleHandler::OnCursorChange(CefRefPtr<CefBrowser> browser,
                                    cef_cursor_type_t type,
                                    const CefCursorInfo &custom_cursor_info)
 {
+  EVENT_TRACE_SCOPE1(OnCursorChange, type);
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
@@ -233,30 +310,57 @@ bool SimpleHandler::OnCursorChange(CefRefPtr<CefBrowser> browser,
 
 void SimpleHandler::GetViewRect(CefRefPtr<CefBrowser> browser, CefRect &rect)
 {
+  EVENT_TRACE_SCOPE1(GetViewRect, browser->GetIdentifier());
   rect.x = rect.y = 0;
-  auto bridge = getBridge(browser->GetIdentifier());
-  if (bridge)
+  auto bridge = getLayoutBridge(browser->GetIdentifier());
+  const CefSize size = bridge ? bridge->viewSize() : CefSize();
+  if (!size.IsEmpty())
   {
-    rect.width = bridge->width;
-    rect.height = bridge->height;
+    rect.width = size.width;
+    rect.height = size.height;
   }
   else
   {
-    rect.width = 1920;
-    rect.height = 1080;
+    // must not be empty, the browser is hidden until its size is known and
+    // asked again once it is mapped to its bridge
+    rect.width = 1;
+    rect.height = 1;
   }
   return;
 }
 
+bool SimpleHandler::GetScreenInfo(CefRefPtr<CefBrowser> browser, CefScreenInfo &screen_info)
+{
+  auto bridge = getLayoutBridge(browser->GetIdentifier());
+  if (!bridge)
+  {
+    return false;
+  }
+  CefRect rect;
+  GetViewRect(browser, rect);
+  screen_info.device_scale_factor = static_cast<float>(bridge->paintScale());
+  screen_info.rect = rect;
+  screen_info.available_rect = rect;
+  return true;
+}
+
 int64_t SimpleHandler::createBrowser(
     FlBinaryMessenger *messenger,
-    FlTextureRegistrar *texture_registrar, const CefString &url, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget *parent)
+    FlTextureRegistrar *texture_registrar, const CefString &url, const CefString &bind_func, const CefString &token, const CefString &access_token, GtkWidget *parent,
+    const std::string &context_key, bool persist_context,
+    inline_content::DocumentRef document)
 {
   CefRefPtr<BrowserBridge> bridge(new BrowserBridge(messenger, texture_registrar, url, bind_func, token, access_token, parent));
+  bridge->setRequestContext(context_key, persist_context);
+  // runs before the browser is created, that task is posted later
+  CefPostTask(TID_UI, base::BindOnce(&BrowserBridge::setInlineDocument, bridge, std::move(document)));
   auto video_outlet_private =
       get_video_outlet_private(bridge->texture_bridge);
   auto texture_id = video_outlet_private->texture_id;
-  browser_list_[texture_id] = bridge;
+  {
+    std::lock_guard<std::mutex> lock(browser_list_mutex_);
+    browser_list_[texture_id] = bridge;
+  }
   return texture_id;
 }
 
@@ -264,22 +368,49 @@ void SimpleHandler::OnPaint(CefRefPtr<CefBrowser> browser, CefRenderHandler::Pai
                             const CefRenderHandler::RectList &dirtyRects, const void *buffer, int w, int h)
 {
   CEF_REQUIRE_UI_THREAD();
-  auto bridge = getBridge(browser->GetIdentifier());
-  if (bridge && !bridge->closing && bridge->texture_bridge)
+  TRACE_EVENT2(kTraceCategory, "SimpleHandler::OnPaint", "type", type, "dirty_rects", dirtyRects.size());
+  const auto frame_begin = EVENT_TRACE_NOW();
   {
-    if (type == PET_POPUP)
-    {
-      bridge->send_buffer(true, buffer, w, h);
-    }
-    else
+    EVENT_TRACE_SCOPE1(OnPaint, type);
+    auto bridge = getBridge(browser->GetIdentifier());
+    if (bridge && !bridge->closing && bridge->texture_bridge)
     {
-      bridge->send_buffer(false, buffer, w, h);
+      if (type == PET_POPUP)
+      {
+        if (bridge->compositesPopup())
+        {
+          bridge->compositeFrame(type, dirtyRects, buffer, w, h);
+        }
+        else
+        {
+          bridge->send_buffer(true, buffer, w, h);
+        }
+      }
+      else if (bridge->acceptViewFrame(w, h))
+      {
+        int64_t pixels = 0;
+        for (const auto &rect : dirtyRects)
+        {
+          pixels += static_cast<int64_t>(rect.width) * rect.height;
+        }
+        bridge->raster_pixels += pixels;
+        if (bridge->compositesPopup())
+        {
+          bridge->compositeFrame(type, dirtyRects, buffer, w, h);
+        }
+        else
+        {
+          bridge->send_buffer(false, buffer, w, h);
+        }
+      }
     }
   }
+  EVENT_TRACE_FRAME(frame_begin);
 }
 
 void SimpleHandler::OnPopupShow(CefRefPtr<CefBrowser> browser, bool show)
 {
+  EVENT_TRACE_SCOPE1(OnPopupShow, show);
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
@@ -289,6 +420,7 @@ void SimpleHandler::OnPopupShow(CefRefPtr<CefBrowser> browser, bool show)
 
 void SimpleHandler::OnPopupSize(CefRefPtr<CefBrowser> browser, const CefRect &rect)
 {
+  EVENT_TRACE_SCOPE1(OnPopupSize, browser->GetIdentifier());
   auto bridge = getBridge(browser->GetIdentifier());
   if (bridge)
   {
@@ -296,42 +428,92 @@ void SimpleHandler::OnPopupSize(CefRefPtr<CefBrowser> browser, const CefRect &re
   }
 }
 
+void SimpleHandler::addPrerendered(CefRefPtr<CefBrowser> browser, int64_t texture_id)
+{
+  CEF_REQUIRE_UI_THREAD();
+  prerendered_[browser->GetIdentifier()].texture_id = texture_id;
+}
+
+std::optional<SimpleHandler::Prerendered> SimpleHandler::adoptPrerendered(int browser_id, CefRefPtr<CefBrowser> companion)
+{
+  CEF_REQUIRE_UI_THREAD();
+  auto it = prerendered_.find(companion->GetIdentifier());
+  if (it == prerendered_.end())
+  {
+    return std::nullopt;
+  }
+  Prerendered prerendered = std::move(it->second);
+  prerendered_.erase(it);
+  cache_.erase(browser_id);
+  cache_[companion->GetIdentifier()] = prerendered.texture_id;
+  return prerendered;
+}
+
 CefRefPtr<BrowserBridge> SimpleHandler::getBridge(int browser_id)
 {
-  if (cache_.count(browser_id))
+  auto it = cache_.find(browser_id);
+  return it != cache_.end() ? getBridgeForTexture(it->second) : nullptr;
+}
+
+CefRefPtr<BrowserBridge> SimpleHandler::getBridgeForTexture(int64_t texture_id)
+{
+  std::lock_guard<std::mutex> lock(browser_list_mutex_);
+  auto it = browser_list_.find(texture_id);
+  return it != browser_list_.end() ? it->second : nullptr;
+}
+
+std::map<int64_t, CefRefPtr<BrowserBridge>> SimpleHandler::bridges()
+{
+  std::lock_guard<std::mutex> lock(browser_list_mutex_);
+  return browser_list_;
+}
+
+CefRefPtr<BrowserBridge> SimpleHandler::getCurrentBridge()
+{
+  std::lock_guard<std::mutex> lock(browser_list_mutex_);
+  for (auto const &[key, val] : browser_list_)
   {
-    int64_t texture_id = cache_[browser_id];
-    if (browser_list_.count(texture_id))
+    if (val->isCurrent)
     {
-      return browser_list_[texture_id];
+      return val;
     }
   }
   return nullptr;
 }
 
-bool SimpleHandler::sendKeyEvent(GdkEventKey *event) {
-  for (auto const &[key, val] : browser_list_)
+CefRefPtr<BrowserBridge> SimpleHandler::getLayoutBridge(int browser_id)
+{
+  auto bridge = getBridge(browser_id);
+  if (!bridge)
   {
-    if (val->isCurrent)
+    // companions lay out at the size of the texture they will replace
+    auto prerendered = prerendered_.find(browser_id);
+    if (prerendered != prerendered_.end())
     {
-      val->sendKeyEvent(event);
-      return true;
+      bridge = getBridgeForTexture(prerendered->second.texture_id);
     }
   }
-  return false;
+  return bridge;
+}
+
+bool SimpleHandler::sendKeyEvent(GdkEventKey *event) {
+  auto bridge = getCurrentBridge();
+  if (!bridge)
+  {
+    return false;
+  }
+  bridge->sendKeyEvent(event);
+  return true;
 }
 
 void SimpleHandler::sendMouseWheelEvent(CefMouseEvent &event,
                                         int deltaX,
                                         int deltaY)
 {
-  for (auto const &[key, val] : browser_list_)
+  auto bridge = getCurrentBridge();
+  if (bridge)
   {
-    if (val->isCurrent)
-    {
-      val->sendMouseWheelEvent(event, deltaX, deltaY);
-      break;
-    }
+    bridge->sendMouseWheelEvent(event, deltaX, deltaY);
   }
 }
 
@@ -340,25 +522,41 @@ void SimpleHandler::sendMouseClickEvent(CefMouseEvent &event,
                                         bool mouseUp,
                                         int clickCount)
 {
-  for (auto const &[key, val] : browser_list_)
+  auto bridge = getCurrentBridge();
+  if (bridge)
   {
-    if (val->isCurrent)
-    {
-      val->sendMouseClickEvent(event, type, mouseUp, clickCount);
-      break;
-    }
+    bridge->sendMouseClickEvent(event, type, mouseUp, clickCount);
   }
 }
 
 void SimpleHandler::sendMouseMoveEvent(CefMouseEvent &event,
                                        bool mouseLeave)
 {
-  for (auto const &[key, val] : browser_list_)
+  auto bridge = getCurrentBridge();
+  if (bridge)
   {
-    if (val->isCurrent)
+    bridge->sendMouseMoveEvent(event, mouseLeave);
+  }
+}
+
+void SimpleHandler::sampleUsage()
+{
+  CEF_REQUIRE_UI_THREAD();
+  for (auto const &[key, val] : bridges())
+  {
+    if (val->browser_ && !val->closing)
     {
-      val->sendMouseMoveEvent(event, mouseLeave);
-      break;
+      val->sampleUsage();
     }
   }
 }
+
+FlValue *SimpleHandler::getResourceUsage()
+{
+  FlValue *value = fl_value_new_map();
+  for (auto const &[key, val] : bridges())
+  {
+    fl_value_set_take(value, fl_value_new_int(key), val->getResourceUsage());
+  }
+  return value;
+}
@@ -6,6 +6,7 @@
 #include "include/cef_client.h"
 #include "include/cef_browser.h"
 #include "include/cef_render_process_handler.h"
+#include "include/cef_request_handler.h"
 
 #include <flutter_linux/flutter_linux.h>
 
@@ -17,13 +18,15 @@
 #include <gdk/gdkx.h>
 
 #include "browser.h"
+#include "resource_request_handler.h"
 
 class SimpleHandler : public CefClient,
                       public CefDisplayHandler,
                       public CefLifeSpanHandler,
                       public CefLoadHandler,
                       public CefRenderHandler,
-                      public CefContextMenuHandler
+                      public CefContextMenuHandler,
+                      public CefRequestHandler
 {
 public:
   SimpleHandler();
@@ -69,6 +72,20 @@ public:
     return this;
   }
   virtual CefRefPtr<CefLoadHandler> GetLoadHandler() override { return this; }
+  virtual CefRefPtr<CefRequestHandler> GetRequestHandler() override { return this; }
+
+  // CefRequestHandler methods:
+  virtual CefRefPtr<CefResourceRequestHandler> GetResourceRequestHandler(
+      CefRefPtr<CefBrowser> browser,
+      CefRefPtr<CefFrame> frame,
+      CefRefPtr<CefRequest> request,
+      bool is_navigation,
+      bool is_download,
+      const CefString &request_initiator,
+      bool &disable_default_handling) override
+  {
+    return resource_request_handler_;
+  }
 
   virtual bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
                                         CefRefPtr<CefFrame> frame,
@@ -94,7 +111,9 @@ public:
   // create new browser and return texture_id for flutter side
   int64_t createBrowser(FlBinaryMessenger *messenger,
                         FlTextureRegistrar *texture_registrar, const CefString &url, const CefString &bind_func,
-                        const CefString &token, const CefString &access_token, GtkWidget* parent);
+                        const CefString &token, const CefString &access_token, GtkWidget* parent,
+                        const std::string &context_key = "", bool persist_context = false,
+                        inline_content::DocumentRef document = nullptr);
 
   // CefLoadHandler methods:
   virtual void OnLoadError(CefRefPtr<CefBrowser> browser,
@@ -105,6 +124,8 @@ public:
 
   virtual void GetViewRect(CefRefPtr<CefBrowser> browser, CefRect &rect) override;
 
+  virtual bool GetScreenInfo(CefRefPtr<CefBrowser> browser, CefScreenInfo &screen_info) override;
+
   virtual void OnPaint(CefRefPtr<CefBrowser> browser, PaintElementType type, const RectList &dirtyRects, const void *buffer, int width, int height) override;
   virtual void OnPopupShow(CefRefPtr<CefBrowser> browser, bool show) override;
 
@@ -131,20 +152,64 @@ public:
 
   CefRefPtr<BrowserBridge> getBridge(int browser_id);
 
+  CefRefPtr<BrowserBridge> getBridgeForTexture(int64_t texture_id);
+
+  // Returns the bridge whose geometry |browser_id| lays out at, including
+  // prerendered companions.
+  CefRefPtr<BrowserBridge> getLayoutBridge(int browser_id);
+
+  // Ask every live browser for its raster pixels and js heap usage. Must be
+  // called on the UI thread.
+  void sampleUsage();
+
+  // Returns a new map of texture id -> resource usage for all browsers.
+  FlValue *getResourceUsage();
+
+  struct Prerendered
+  {
+    int64_t texture_id = 0;
+    int renderer_pid = 0;
+    std::string title;
+  };
+
+  // Tracks |browser| as the hidden companion of |texture_id|, its paints and
+  // events are dropped until it is adopted. Must be called on the UI thread.
+  void addPrerendered(CefRefPtr<CefBrowser> browser, int64_t texture_id);
+
+  // Routes the callbacks of |companion| to the texture shown by the browser
+  // |browser_id| so far. Returns nothing if the companion is gone. Must be
+  // called on the UI thread.
+  std::optional<Prerendered> adoptPrerendered(int browser_id, CefRefPtr<CefBrowser> companion);
+
 private:
   // Platform-specific implementation.
   void PlatformTitleChange(CefRefPtr<CefBrowser> browser,
                            const CefString &title);
 
+  // Copy of |browser_list_| to call into the bridges without the lock.
+  std::map<int64_t, CefRefPtr<BrowserBridge>> bridges();
+
+  // The bridge input goes to, nullptr if no webview is current.
+  CefRefPtr<BrowserBridge> getCurrentBridge();
+
+  // guards |browser_list_|, createBrowser and the input events run on the
+  // platform thread
+  std::mutex browser_list_mutex_;
+
   // Map of existing browser windows (texture id -> bridge). Needs to be cleaned when browser destroys
   std::map<int64_t, CefRefPtr<BrowserBridge>> browser_list_;
 
   // Map of browser id -> texture id
   std::map<int, int64_t> cache_;
 
+  // Map of companion browser id -> prerender state, not in |cache_| yet
+  std::map<int, Prerendered> prerendered_;
+
   // Handler is closing
   bool is_closing_;
 
+  CefRefPtr<ResourceRequestHandler> resource_request_handler_;
+
   // Include the default reference counting implementation.
   IMPLEMENT_REFCOUNTING(SimpleHandler);
 };
\ No newline at end of file
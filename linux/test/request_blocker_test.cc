@@ -0,0 +1,150 @@
+#include "request_blocker.h"
+
+#include "test.h"
+
+namespace
+{
+  using request_blocker::FilterList;
+
+  std::shared_ptr<const FilterList> Compile(const std::string &rules)
+  {
+    size_t count = 0;
+    return FilterList::Compile(rules, count);
+  }
+
+  bool Blocks(const std::shared_ptr<const FilterList> &list, const std::string &url,
+              cef_resource_type_t type = RT_SCRIPT, bool third_party = false)
+  {
+    return list->ShouldBlock(url, type, third_party);
+  }
+
+  void TestRuleCount()
+  {
+    size_t count = 0;
+    FilterList::Compile("! comment\n[Adblock Plus 2.0]\n||ads.example.com^\nexample.org##.banner\n"
+                        "/banner/*/ad.js\n@@||ads.example.com/ok\n0.0.0.0 tracker.net\n",
+                        count);
+    EXPECT_EQ(4u, count);
+  }
+
+  void TestHostRules()
+  {
+    auto list = Compile("||ads.example.com^\n0.0.0.0 tracker.net\n");
+    EXPECT_TRUE(Blocks(list, "https://ads.example.com/x.js"));
+    EXPECT_TRUE(Blocks(list, "https://cdn.ads.example.com/x.js"));
+    EXPECT_TRUE(Blocks(list, "http://user@tracker.net:8080/p"));
+    EXPECT_FALSE(Blocks(list, "https://badads.example.com/x.js"));
+    EXPECT_FALSE(Blocks(list, "https://example.com/ads.example.com"));
+    // top level documents are only blocked by $document rules
+    EXPECT_FALSE(Blocks(list, "https://ads.example.com/", RT_MAIN_FRAME));
+  }
+
+  void TestPatterns()
+  {
+    auto list = Compile("/banner/*/ad.js\n|http://plain.\n.swf|\n||cdn.example.com/ads/\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/banner/300x250/ad.js"));
+    EXPECT_FALSE(Blocks(list, "https://example.com/banner/ad.js"));
+    EXPECT_TRUE(Blocks(list, "http://plain.example.com/"));
+    EXPECT_FALSE(Blocks(list, "https://plain.example.com/?u=http://plain."));
+    EXPECT_TRUE(Blocks(list, "https://example.com/movie.swf"));
+    EXPECT_FALSE(Blocks(list, "https://example.com/movie.swf?x=1"));
+    EXPECT_TRUE(Blocks(list, "https://img.cdn.example.com/ads/1.png"));
+    EXPECT_FALSE(Blocks(list, "https://notcdn.example.com/ads/1.png"));
+  }
+
+  void TestSeparator()
+  {
+    auto list = Compile("&ad_id=^\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/p?x=1&ad_id=&y"));
+    EXPECT_TRUE(Blocks(list, "https://example.com/p?x=1&ad_id="));
+    EXPECT_FALSE(Blocks(list, "https://example.com/p?x=1&ad_id=7"));
+  }
+
+  void TestRepeatedLiteral()
+  {
+    // the literal start occurs several times, only the last one matches
+    auto list = Compile("track*pixel.gif\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/track/track/track/pixel.gif"));
+    EXPECT_FALSE(Blocks(list, "https://example.com/track/track/track/pixel.png"));
+  }
+
+  void TestShortRules()
+  {
+    // no literal of three characters, checked for every url
+    auto list = Compile("/ad/\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/ad/1.png"));
+    EXPECT_FALSE(Blocks(list, "https://example.com/add/1.png"));
+  }
+
+  void TestExceptions()
+  {
+    auto list = Compile("||ads.example.com^\n@@||ads.example.com/ok/\n");
+    EXPECT_TRUE(Blocks(list, "https://ads.example.com/bad/1.js"));
+    EXPECT_FALSE(Blocks(list, "https://ads.example.com/ok/1.js"));
+  }
+
+  void TestOptions()
+  {
+    auto list = Compile("/track.js$script\n/pixel.$~image\n/widget.$third-party\n/odd.$popup\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/track.js", RT_SCRIPT));
+    EXPECT_FALSE(Blocks(list, "https://example.com/track.js", RT_IMAGE));
+    EXPECT_TRUE(Blocks(list, "https://example.com/pixel.js", RT_SCRIPT));
+    EXPECT_FALSE(Blocks(list, "https://example.com/pixel.gif", RT_IMAGE));
+    EXPECT_TRUE(Blocks(list, "https://other.com/widget.js", RT_SCRIPT, true));
+    EXPECT_FALSE(Blocks(list, "https://other.com/widget.js", RT_SCRIPT, false));
+    // unknown options are skipped instead of guessed
+    EXPECT_FALSE(Blocks(list, "https://example.com/odd.html"));
+  }
+
+  void TestCaseInsensitive()
+  {
+    auto list = Compile("/Banner/Ad\n");
+    EXPECT_TRUE(Blocks(list, "https://example.com/banner/ad.png"));
+  }
+
+  void TestThirdParty()
+  {
+    EXPECT_FALSE(request_blocker::IsThirdParty("https://cdn.example.com/x", "https://www.example.com/"));
+    EXPECT_TRUE(request_blocker::IsThirdParty("https://cdn.other.com/x", "https://www.example.com/"));
+    EXPECT_FALSE(request_blocker::IsThirdParty("https://a.shop.co.uk/x", "https://b.shop.co.uk/"));
+    EXPECT_TRUE(request_blocker::IsThirdParty("https://a.shop.co.uk/x", "https://other.co.uk/"));
+    EXPECT_FALSE(request_blocker::IsThirdParty("https://a.com/x", ""));
+  }
+
+  void TestRegistry()
+  {
+    auto *registry = request_blocker::Registry::GetInstance();
+    size_t count = 0;
+    auto list = FilterList::Compile("||ads.example.com^\n", count);
+    registry->SetFilterList(1, std::move(list), count);
+    registry->OnResponseSize(RT_SCRIPT, 1000);
+    registry->OnResponseSize(RT_SCRIPT, 3000);
+    EXPECT_TRUE(registry->ShouldBlock(1, "https://ADS.example.com/x.js", "https://site.com/", RT_SCRIPT));
+    EXPECT_FALSE(registry->ShouldBlock(1, "https://example.com/x.js", "https://site.com/", RT_SCRIPT));
+    EXPECT_FALSE(registry->ShouldBlock(2, "https://ads.example.com/x.js", "https://site.com/", RT_SCRIPT));
+    registry->Copy(1, 2);
+    EXPECT_TRUE(registry->ShouldBlock(2, "https://ads.example.com/x.js", "https://site.com/", RT_SCRIPT));
+    const auto stats = registry->GetStats(1);
+    EXPECT_EQ(1u, stats.blocked_requests);
+    EXPECT_EQ(2000u, stats.estimated_bytes_saved);
+    EXPECT_EQ(1u, stats.rules);
+    registry->Remove(1);
+    EXPECT_FALSE(registry->ShouldBlock(1, "https://ads.example.com/x.js", "https://site.com/", RT_SCRIPT));
+  }
+}
+
+int main()
+{
+  TestRuleCount();
+  TestHostRules();
+  TestPatterns();
+  TestSeparator();
+  TestRepeatedLiteral();
+  TestShortRules();
+  TestExceptions();
+  TestOptions();
+  TestCaseInsensitive();
+  TestThirdParty();
+  TestRegistry();
+  return test::Report("request_blocker_test");
+}
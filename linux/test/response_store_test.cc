@@ -0,0 +1,140 @@
+#include "response_store.h"
+
+#include "test.h"
+
+namespace
+{
+  using namespace response_cache;
+
+  ResponseRef MakeResponse(size_t body_bytes, Clock::time_point expires, HeaderList vary = {})
+  {
+    auto response = std::make_shared<Response>();
+    response->status = 200;
+    response->body.assign(body_bytes, 'x');
+    response->vary = std::move(vary);
+    response->expires = expires;
+    return response;
+  }
+
+  void TestParseCacheControl()
+  {
+    Directives directives = ParseCacheControl("public, Max-Age=60, s-maxage=\"30\"");
+    EXPECT_EQ(60, directives.max_age);
+    EXPECT_EQ(30, directives.s_maxage);
+    EXPECT_FALSE(directives.no_store);
+    EXPECT_FALSE(directives.no_cache);
+    EXPECT_FALSE(directives.is_private);
+
+    directives = ParseCacheControl("no-store,no-cache , private");
+    EXPECT_TRUE(directives.no_store);
+    EXPECT_TRUE(directives.no_cache);
+    EXPECT_TRUE(directives.is_private);
+    EXPECT_EQ(-1, directives.max_age);
+    EXPECT_EQ(-1, directives.s_maxage);
+
+    directives = ParseCacheControl("");
+    EXPECT_EQ(-1, directives.max_age);
+    EXPECT_FALSE(directives.no_store);
+  }
+
+  void TestParseHttpDate()
+  {
+    time_t time = 0;
+    EXPECT_TRUE(ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", time));
+    EXPECT_EQ(static_cast<time_t>(784111777), time);
+    EXPECT_FALSE(ParseHttpDate("yesterday", time));
+    EXPECT_FALSE(ParseHttpDate("", time));
+  }
+
+  void TestFreshness()
+  {
+    const time_t now = 784111777;
+    // s-maxage wins over max-age, Age is taken off
+    EXPECT_EQ(30, FreshnessLifetime(ParseCacheControl("max-age=60, s-maxage=30"), "", "", "", now));
+    EXPECT_EQ(50, FreshnessLifetime(ParseCacheControl("max-age=60"), "", "", "10", now));
+    EXPECT_TRUE(FreshnessLifetime(ParseCacheControl("max-age=60"), "", "", "90", now) <= 0);
+    // max-age wins over Expires
+    EXPECT_EQ(60, FreshnessLifetime(ParseCacheControl("max-age=60"), "Sun, 06 Nov 1994 09:49:37 GMT", "", "", now));
+    // Expires counts from Date, or from now without one
+    EXPECT_EQ(120, FreshnessLifetime(Directives(), "Sun, 06 Nov 1994 08:51:37 GMT",
+                                     "Sun, 06 Nov 1994 08:49:37 GMT", "", now + 1000));
+    EXPECT_EQ(3600, FreshnessLifetime(Directives(), "Sun, 06 Nov 1994 09:49:37 GMT", "garbage", "", now));
+    EXPECT_TRUE(FreshnessLifetime(Directives(), "0", "", "", now) <= 0);
+    // nothing is guessed without an explicit lifetime
+    EXPECT_EQ(0, FreshnessLifetime(Directives(), "", "", "", now));
+  }
+
+  void TestLookupExpires()
+  {
+    const auto now = Clock::now();
+    Store store;
+    store.Reset(1 << 20);
+    EXPECT_TRUE(store.Insert("1 https://api/a", MakeResponse(10, now + std::chrono::seconds(5))));
+    EXPECT_TRUE(store.Lookup("1 https://api/a", {}, now) != nullptr);
+    // keys of other request contexts do not match
+    EXPECT_TRUE(store.Lookup("2 https://api/a", {}, now) == nullptr);
+    EXPECT_TRUE(store.Lookup("1 https://api/a", {}, now + std::chrono::seconds(5)) == nullptr);
+    EXPECT_EQ(0u, store.entries());
+    EXPECT_EQ(0, store.bytes());
+  }
+
+  void TestVary()
+  {
+    const auto now = Clock::now();
+    const auto later = now + std::chrono::seconds(60);
+    Store store;
+    store.Reset(1 << 20);
+    store.Insert("k", MakeResponse(10, later, {{"accept-language", "en"}}));
+    store.Insert("k", MakeResponse(20, later, {{"accept-language", "de"}}));
+    EXPECT_EQ(2u, store.entries());
+    auto de = store.Lookup("k", {{"accept-language", "de"}}, now);
+    EXPECT_TRUE(de && de->body.size() == 20);
+    EXPECT_TRUE(store.Lookup("k", {{"accept-language", "fr"}}, now) == nullptr);
+    EXPECT_TRUE(store.Lookup("k", {}, now) == nullptr);
+    // the same variant is replaced
+    store.Insert("k", MakeResponse(30, later, {{"accept-language", "en"}}));
+    EXPECT_EQ(2u, store.entries());
+    auto en = store.Lookup("k", {{"accept-language", "en"}}, now);
+    EXPECT_TRUE(en && en->body.size() == 30);
+  }
+
+  void TestLruEviction()
+  {
+    const auto now = Clock::now();
+    const auto later = now + std::chrono::seconds(60);
+    const int64_t entry = MakeResponse(1000, later)->Size();
+    Store store;
+    // four entries, each at most a quarter
+    store.Reset(entry * 4);
+    EXPECT_TRUE(store.Insert("a", MakeResponse(1000, later)));
+    EXPECT_TRUE(store.Insert("b", MakeResponse(1000, later)));
+    EXPECT_TRUE(store.Insert("c", MakeResponse(1000, later)));
+    EXPECT_TRUE(store.Insert("d", MakeResponse(1000, later)));
+    EXPECT_EQ(entry * 4, store.bytes());
+    // a becomes the most recently used, b is evicted next
+    EXPECT_TRUE(store.Lookup("a", {}, now) != nullptr);
+    EXPECT_TRUE(store.Insert("e", MakeResponse(1000, later)));
+    EXPECT_EQ(4u, store.entries());
+    EXPECT_EQ(1u, store.evictions());
+    EXPECT_TRUE(store.Lookup("b", {}, now) == nullptr);
+    EXPECT_TRUE(store.Lookup("a", {}, now) != nullptr);
+    EXPECT_TRUE(store.Lookup("c", {}, now) != nullptr);
+    // larger than a quarter of the limit
+    EXPECT_FALSE(store.Insert("f", MakeResponse(1001, later)));
+    EXPECT_EQ(4u, store.entries());
+    store.Reset(0);
+    EXPECT_EQ(0u, store.entries());
+    EXPECT_FALSE(store.Insert("a", MakeResponse(0, later)));
+  }
+}
+
+int main()
+{
+  TestParseCacheControl();
+  TestParseHttpDate();
+  TestFreshness();
+  TestLookupExpires();
+  TestVary();
+  TestLruEviction();
+  return test::Report("response_store_test");
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the plugin's CEF independent logic, each test binary
+// returns non-zero when a check failed.
+namespace test
+{
+  inline int &Failures()
+  {
+    static int failures = 0;
+    return failures;
+  }
+
+  inline void Check(bool passed, const char *expression, const char *file, int line)
+  {
+    if (!passed)
+    {
+      fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+      Failures()++;
+    }
+  }
+
+  inline int Report(const char *name)
+  {
+    if (Failures())
+    {
+      fprintf(stderr, "%s: %d checks failed\n", name, Failures());
+      return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+  }
+}
+
+#define EXPECT_TRUE(condition) test::Check((condition), #condition, __FILE__, __LINE__)
+#define EXPECT_FALSE(condition) test::Check(!(condition), "!(" #condition ")", __FILE__, __LINE__)
+#define EXPECT_EQ(expected, actual) \
+  test::Check((expected) == (actual), #expected " == " #actual, __FILE__, __LINE__)
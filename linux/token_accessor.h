@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "include/cef_v8.h"
+
+// Tokens of one browser, owned by the renderer delegate and updated in place
+// when the browser process sends new values.
+struct TokenValues
+{
+  std::string token;
+  std::string access_token;
+};
+
+// Serves the "token" and "access_token" properties of the token object
+// straight from renderer memory, pages always read the latest values.
+class TokenAccessor : public CefV8Accessor
+{
+public:
+  explicit TokenAccessor(std::shared_ptr<const TokenValues> values) : values_(std::move(values))
+  {
+  }
+
+  virtual bool Get(const CefString &name,
+                   const CefRefPtr<CefV8Value> object,
+                   CefRefPtr<CefV8Value> &retval,
+                   CefString &exception) override
+  {
+    if (name == "token")
+    {
+      retval = CefV8Value::CreateString(values_->token);
+      return true;
+    }
+    if (name == "access_token")
+    {
+      retval = CefV8Value::CreateString(values_->access_token);
+      return true;
+    }
+    return false;
+  }
+
+  virtual bool Set(const CefString &name,
+                   const CefRefPtr<CefV8Value> object,
+                   const CefRefPtr<CefV8Value> value,
+                   CefString &exception) override
+  {
+    // only the app sets tokens
+    return name == "token" || name == "access_token";
+  }
+
+private:
+  std::shared_ptr<const TokenValues> values_;
+
+  IMPLEMENT_REFCOUNTING(TokenAccessor);
+};
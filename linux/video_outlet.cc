@@ -1,5 +1,9 @@
 #include "video_outlet.h"
 
+#include "include/base/cef_trace_event.h"
+#include "event_tracer.h"
+#include "webview.h"
+
 G_DEFINE_TYPE_WITH_CODE(VideoOutlet, video_outlet,
                         fl_pixel_buffer_texture_get_type(),
                         G_ADD_PRIVATE(VideoOutlet))
@@ -11,15 +15,39 @@ static gboolean video_outlet_copy_pixels(FlPixelBufferTexture *texture,
                                          uint32_t *width, uint32_t *height,
                                          GError **error)
 {
+  TRACE_EVENT0(kTraceCategory, "video_outlet_copy_pixels");
+  EVENT_TRACE_SCOPE(CopyPixels);
   auto video_outlet_private =
       (VideoOutletPrivate *)video_outlet_get_instance_private(
           DART_VLC_VIDEO_OUTLET(texture));
 
   const std::lock_guard<std::mutex> lock(video_outlet_private->mutex);
+  // Flutter is done with the buffer handed out by the previous call
+  const bool stale = video_outlet_private->previous_stale;
+  video_outlet_private->previous_stale = false;
+  if (!video_outlet_private->buffer)
+  {
+    if (stale)
+    {
+      video_outlet_private->released_previous_bytes += video_outlet_private->previous_bytes;
+    }
+    video_outlet_private->previous_buffer.reset();
+    video_outlet_private->previous_bytes = 0;
+    static const uint8_t kTransparent[4] = {0, 0, 0, 0};
+    *width = 1;
+    *height = 1;
+    *out_buffer = kTransparent;
+    return TRUE;
+  }
   *width = video_outlet_private->video_width;
   *height = video_outlet_private->video_height;
-  const auto size = video_outlet_private->video_width * video_outlet_private->video_height * 4;
+  const size_t size = static_cast<size_t>(video_outlet_private->video_width) * video_outlet_private->video_height * 4;
+  if (stale && video_outlet_private->previous_bytes > size)
+  {
+    video_outlet_private->released_previous_bytes += video_outlet_private->previous_bytes - size;
+  }
   video_outlet_private->previous_buffer.reset(new uint8_t[size]);
+  video_outlet_private->previous_bytes = size;
   memcpy(video_outlet_private->previous_buffer.get(), video_outlet_private->buffer.get(), size);
   *out_buffer = video_outlet_private->previous_buffer.get();
   return TRUE;
@@ -38,4 +66,80 @@ VideoOutlet *video_outlet_new()
 VideoOutletPrivate *get_video_outlet_private(VideoOutlet *video_outlet)
 {
   return (VideoOutletPrivate *)video_outlet_get_instance_private(video_outlet);
-}
\ No newline at end of file
+}
+
+static size_t video_outlet_buffer_bytes(VideoOutletPrivate *video_outlet_private)
+{
+  if (!video_outlet_private->buffer)
+  {
+    return 0;
+  }
+  return static_cast<size_t>(video_outlet_private->video_width) * video_outlet_private->video_height * 4;
+}
+
+size_t video_outlet_release_buffers(VideoOutlet *video_outlet)
+{
+  auto video_outlet_private = get_video_outlet_private(video_outlet);
+  const std::lock_guard<std::mutex> lock(video_outlet_private->mutex);
+  const size_t freed = video_outlet_buffer_bytes(video_outlet_private);
+  video_outlet_private->buffer.reset();
+  video_outlet_private->previous_stale = true;
+  video_outlet_private->video_width = 0;
+  video_outlet_private->video_height = 0;
+  return freed;
+}
+
+size_t video_outlet_shrink_buffers(VideoOutlet *video_outlet, int divisor, size_t *snapshot_bytes)
+{
+  auto video_outlet_private = get_video_outlet_private(video_outlet);
+  const std::lock_guard<std::mutex> lock(video_outlet_private->mutex);
+  *snapshot_bytes = 0;
+  const int width = video_outlet_private->video_width;
+  const int height = video_outlet_private->video_height;
+  if (!video_outlet_private->buffer || divisor < 2 || width < divisor || height < divisor)
+  {
+    return 0;
+  }
+  const size_t before = video_outlet_buffer_bytes(video_outlet_private);
+
+  // box filter, each snapshot pixel averages a |divisor| square
+  const int snapshot_width = width / divisor;
+  const int snapshot_height = height / divisor;
+  const uint8_t *source = video_outlet_private->buffer.get();
+  std::unique_ptr<uint8_t[]> snapshot(new uint8_t[static_cast<size_t>(snapshot_width) * snapshot_height * 4]);
+  const int samples = divisor * divisor;
+  for (int y = 0; y < snapshot_height; y++)
+  {
+    for (int x = 0; x < snapshot_width; x++)
+    {
+      uint32_t sum[4] = {0, 0, 0, 0};
+      for (int dy = 0; dy < divisor; dy++)
+      {
+        const uint8_t *row = source + (static_cast<size_t>(y * divisor + dy) * width + x * divisor) * 4;
+        for (int dx = 0; dx < divisor * 4; dx++)
+        {
+          sum[dx & 3] += row[dx];
+        }
+      }
+      uint8_t *pixel = snapshot.get() + (static_cast<size_t>(y) * snapshot_width + x) * 4;
+      for (int c = 0; c < 4; c++)
+      {
+        pixel[c] = static_cast<uint8_t>(sum[c] / samples);
+      }
+    }
+  }
+
+  video_outlet_private->buffer = std::move(snapshot);
+  video_outlet_private->previous_stale = true;
+  video_outlet_private->video_width = snapshot_width;
+  video_outlet_private->video_height = snapshot_height;
+  *snapshot_bytes = video_outlet_buffer_bytes(video_outlet_private);
+  return before - *snapshot_bytes;
+}
+
+uint64_t video_outlet_released_previous_bytes(VideoOutlet *video_outlet)
+{
+  auto video_outlet_private = get_video_outlet_private(video_outlet);
+  const std::lock_guard<std::mutex> lock(video_outlet_private->mutex);
+  return video_outlet_private->released_previous_bytes;
+}
@@ -18,12 +18,18 @@ struct _VideoOutletClass
 struct VideoOutletPrivate
 {
   int64_t texture_id = 0;
-  std::unique_ptr<uint8_t> buffer;
+  std::unique_ptr<uint8_t[]> buffer;
   int32_t video_width = 0;
   int32_t video_height = 0;
 
   // save buffer here for render in flutter
-  std::unique_ptr<uint8_t> previous_buffer;
+  std::unique_ptr<uint8_t[]> previous_buffer;
+  size_t previous_bytes = 0;
+  // set when the frame was released or shrunk, Flutter may still read
+  // |previous_buffer| until copy_pixels is called again and frees it
+  bool previous_stale = false;
+  // bytes of stale previous buffers copy_pixels freed so far
+  uint64_t released_previous_bytes = 0;
 
   std::mutex mutex;
 };
@@ -32,4 +38,18 @@ VideoOutlet *video_outlet_new();
 
 VideoOutletPrivate *get_video_outlet_private(VideoOutlet *video_outlet);
 
+// Frees the frame buffer, the outlet shows a transparent pixel until the
+// next frame. The copy Flutter uploads from is freed by the next
+// copy_pixels. Returns the number of bytes freed right away.
+size_t video_outlet_release_buffers(VideoOutlet *video_outlet);
+
+// Replaces the frame with a copy downscaled by |divisor| in both directions,
+// which the texture stretches until the next frame. The copy Flutter uploads
+// from shrinks with the next copy_pixels. Returns the number of bytes freed
+// right away, the snapshot size is stored in |snapshot_bytes|.
+size_t video_outlet_shrink_buffers(VideoOutlet *video_outlet, int divisor, size_t *snapshot_bytes);
+
+// Bytes copy_pixels freed so far after a release or shrink.
+uint64_t video_outlet_released_previous_bytes(VideoOutlet *video_outlet);
+
 #endif
\ No newline at end of file
@@ -4,6 +4,12 @@ constexpr auto kEventType = "type";
 constexpr auto kEventValue = "value";
 constexpr auto kErrorInvalidArgs = "invalidArguments";
 
+// Category of the plugin's own events in chrome tracing
+constexpr auto kTraceCategory = "dart_cef";
+
+// Custom scheme for content served by the plugin itself
+constexpr auto kAppScheme = "dartcef";
+
 enum class WebviewLoadingState
 {
   InProcess,